@@ -0,0 +1,436 @@
+/*
+Exact n! and C(n,k) as big integers for n up to about 10^6
+
+Multiplying 2..n one at a time into the result (as fact in
+py/exact_math/integer.py) is quadratic in the result size, since every step
+passes over the whole number. Here the result is built from its prime
+factorization instead. The primes up to n come from a sieve, with exponents
+  v_p(n!) = sum floor(n/p^i)                          (legendre)
+  v_p(C(n,k)) = v_p(n!) - v_p(k!) - v_p((n-k)!)
+Then with Q_j = product of the odd primes whose exponent has bit j set,
+  prod p^e_p = (..((Q_t)^2 * Q_(t-1))^2 .. )^2 * Q_0
+and the power of 2 is a final shift. Each Q_j is a balanced product tree
+(primes packed into 64 bit leaves first), so the multiplications are between
+numbers of similar size. Those use karatsuba (3 half size products instead of
+4) above 40 limbs, which makes the total cost O(M(size) log n) instead of the
+quadratic loop.
+*/
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// r[0..an+bn) = a*b (schoolbook, r must not overlap a or b)
+static void _mul_school(const uint32_t *a, size_t an, const uint32_t *b,
+    size_t bn, uint32_t *r)
+{
+    std::fill(r,r+an+bn,0);
+    for (size_t i = 0; i < an; ++i)
+    {
+        uint64_t c = 0;
+        for (size_t j = 0; j < bn; ++j)
+        {
+            c += (uint64_t) a[i]*b[j] + r[i+j];
+            r[i+j] = c;
+            c >>= 32;
+        }
+        r[i+bn] = c;
+    }
+}
+
+// r[0..rn) += a[0..an), returns the carry out of r
+static uint32_t _add_to(uint32_t *r, size_t rn, const uint32_t *a, size_t an)
+{
+    uint64_t c = 0;
+    size_t i = 0;
+    for (; i < an; ++i)
+    {
+        c += (uint64_t) r[i] + a[i];
+        r[i] = c;
+        c >>= 32;
+    }
+    for (; c && i < rn; ++i)
+    {
+        c += r[i];
+        r[i] = c;
+        c >>= 32;
+    }
+    return c;
+}
+
+// r[0..rn) -= a[0..an) for r >= a
+static void _sub_from(uint32_t *r, size_t rn, const uint32_t *a, size_t an)
+{
+    int64_t c = 0;
+    size_t i = 0;
+    for (; i < an; ++i)
+    {
+        c += (int64_t) r[i] - a[i];
+        r[i] = c;
+        c >>= 32;
+    }
+    for (; c && i < rn; ++i)
+    {
+        c += r[i];
+        r[i] = c;
+        c >>= 32;
+    }
+}
+
+static constexpr size_t _KARATSUBA_MIN = 40;
+
+// r[0..2n) = a[0..n) * b[0..n) by karatsuba
+static void _mul_karatsuba(const uint32_t *a, const uint32_t *b, size_t n,
+    uint32_t *r)
+{
+    if (n < _KARATSUBA_MIN)
+    {
+        _mul_school(a,n,b,n,r);
+        return;
+    }
+    // a = a1*B^h + a0, b = b1*B^h + b0
+    const size_t h = n/2, m = n-h;
+    _mul_karatsuba(a,b,h,r); // a0*b0 in r[0..2h)
+    _mul_karatsuba(a+h,b+h,m,r+2*h); // a1*b1 in r[2h..2n)
+    // (a0+a1)*(b0+b1) - a0*b0 - a1*b1 added at position h
+    std::vector<uint32_t> sa(a+h,a+n), sb(b+h,b+n), z(2*m+2);
+    sa.push_back(_add_to(sa.data(),m,a,h));
+    sb.push_back(_add_to(sb.data(),m,b,h));
+    _mul_karatsuba(sa.data(),sb.data(),m+1,z.data());
+    _sub_from(z.data(),z.size(),r,2*h);
+    _sub_from(z.data(),z.size(),r+2*h,2*m);
+    size_t zn = z.size();
+    while (zn && z[zn-1] == 0)
+        --zn;
+    _add_to(r+h,2*n-h,z.data(),zn);
+}
+
+// r[0..an+bn) = a*b, splitting the longer operand into pieces the size of
+// the shorter one for karatsuba
+static void _mul(const uint32_t *a, size_t an, const uint32_t *b, size_t bn,
+    uint32_t *r)
+{
+    if (an < bn)
+    {
+        std::swap(a,b);
+        std::swap(an,bn);
+    }
+    if (bn < _KARATSUBA_MIN)
+    {
+        _mul_school(a,an,b,bn,r);
+        return;
+    }
+    std::fill(r,r+an+bn,0);
+    std::vector<uint32_t> piece(bn), t(2*bn);
+    for (size_t s = 0; s < an; s += bn)
+    {
+        const size_t len = std::min(bn,an-s);
+        std::fill(piece.begin(),piece.end(),0);
+        std::copy(a+s,a+s+len,piece.begin());
+        _mul_karatsuba(piece.data(),b,bn,t.data());
+        _add_to(r+s,an+bn-s,t.data(),std::min(2*bn,an+bn-s));
+    }
+}
+
+// nonnegative big integer (32 bit limbs, least significant first, no leading
+// zero limbs)
+struct bigint
+{
+    std::vector<uint32_t> d;
+
+    bigint(uint64_t v = 0)
+    {
+        for (; v; v >>= 32)
+            d.push_back(v);
+    }
+
+    friend bigint operator*(const bigint& a, const bigint& b)
+    {
+        bigint ret;
+        if (a.d.empty() || b.d.empty())
+            return ret;
+        ret.d.resize(a.d.size()+b.d.size());
+        _mul(a.d.data(),a.d.size(),b.d.data(),b.d.size(),ret.d.data());
+        ret._trim();
+        return ret;
+    }
+
+    // *this *= m for m < 2^32
+    void mul_small(uint32_t m)
+    {
+        uint64_t c = 0;
+        for (uint32_t& x : d)
+        {
+            c += (uint64_t) x*m;
+            x = c;
+            c >>= 32;
+        }
+        if (c)
+            d.push_back(c);
+        _trim();
+    }
+
+    // *this /= m for 0 < m < 2^32, returns the remainder
+    uint32_t div_small(uint32_t m)
+    {
+        uint64_t r = 0;
+        for (size_t i = d.size(); i--;)
+        {
+            r = r << 32 | d[i];
+            d[i] = r / m;
+            r %= m;
+        }
+        _trim();
+        return r;
+    }
+
+    // remainder mod m without changing the value
+    uint32_t mod_small(uint32_t m) const
+    {
+        uint64_t r = 0;
+        for (size_t i = d.size(); i--;)
+            r = (r << 32 | d[i]) % m;
+        return r;
+    }
+
+    // *this *= 2^s
+    void shift_left(size_t s)
+    {
+        if (d.empty())
+            return;
+        const size_t w = s / 32, b = s % 32;
+        d.insert(d.begin(),w,0);
+        if (b)
+        {
+            d.push_back(0);
+            for (size_t i = d.size(); i-- > w;)
+                d[i] = d[i] << b | (i > w ? d[i-1] >> (32-b) : 0);
+        }
+        _trim();
+    }
+
+    friend bool operator==(const bigint& a, const bigint& b)
+    { return a.d == b.d; }
+
+    // decimal representation (quadratic)
+    std::string str() const
+    {
+        bigint v = *this;
+        std::string ret;
+        while (!v.d.empty())
+        {
+            uint32_t r = v.div_small(1000000000);
+            for (int j = 0; j < 9; ++j, r /= 10)
+                ret.push_back('0' + r % 10);
+        }
+        while (ret.size() > 1 && ret.back() == '0')
+            ret.pop_back();
+        if (ret.empty())
+            ret.push_back('0');
+        std::reverse(ret.begin(),ret.end());
+        return ret;
+    }
+
+private:
+    void _trim()
+    {
+        while (!d.empty() && d.back() == 0)
+            d.pop_back();
+    }
+};
+
+// primes up to n
+static std::vector<uint32_t> _primes(uint32_t n)
+{
+    std::vector<bool> comp(n+1);
+    std::vector<uint32_t> ret;
+    for (uint64_t i = 2; i <= n; ++i)
+        if (!comp[i])
+        {
+            ret.push_back(i);
+            for (uint64_t j = i*i; j <= n; j += i)
+                comp[j] = true;
+        }
+    return ret;
+}
+
+// exponent of p in n!
+static uint64_t _legendre(uint64_t n, uint64_t p)
+{
+    uint64_t v = 0;
+    for (n /= p; n; n /= p)
+        v += n;
+    return v;
+}
+
+// product of f[lo..hi) by a balanced tree
+static bigint _product(const std::vector<uint64_t>& f, size_t lo, size_t hi)
+{
+    if (hi - lo == 0)
+        return 1;
+    if (hi - lo == 1)
+        return f[lo];
+    const size_t mid = (lo + hi) / 2;
+    return _product(f,lo,mid) * _product(f,mid,hi);
+}
+
+// product of ps[i]^es[i]
+static bigint _from_exponents(const std::vector<uint32_t>& ps,
+    const std::vector<uint64_t>& es)
+{
+    uint64_t e2 = 0, all = 0;
+    for (size_t i = 0; i < ps.size(); ++i)
+    {
+        if (ps[i] == 2)
+            e2 = es[i];
+        else
+            all |= es[i];
+    }
+    bigint ret = 1;
+    for (int j = 63 - __builtin_clzll(all | 1); j >= 0; --j)
+    {
+        // odd primes with bit j of the exponent set, packed into 64 bits
+        std::vector<uint64_t> f;
+        uint64_t w = 1;
+        for (size_t i = 0; i < ps.size(); ++i)
+            if (ps[i] != 2 && (es[i] >> j & 1))
+            {
+                if (w > ~0ull / ps[i])
+                {
+                    f.push_back(w);
+                    w = 1;
+                }
+                w *= ps[i];
+            }
+        f.push_back(w);
+        ret = ret * ret * _product(f,0,f.size());
+    }
+    ret.shift_left(e2);
+    return ret;
+}
+
+// n!
+bigint big_factorial(uint32_t n)
+{
+    const std::vector<uint32_t> ps = _primes(n);
+    std::vector<uint64_t> es(ps.size());
+    for (size_t i = 0; i < ps.size(); ++i)
+        es[i] = _legendre(n,ps[i]);
+    return _from_exponents(ps,es);
+}
+
+// C(n,k), 0 for k > n
+bigint big_binomial(uint32_t n, uint32_t k)
+{
+    if (k > n)
+        return 0;
+    const std::vector<uint32_t> ps = _primes(n);
+    std::vector<uint64_t> es(ps.size());
+    for (size_t i = 0; i < ps.size(); ++i)
+        es[i] = _legendre(n,ps[i]) - _legendre(k,ps[i])
+            - _legendre(n-k,ps[i]);
+    return _from_exponents(ps,es);
+}
+
+// multiply 2..n into the result one at a time for comparison
+static bigint _factorial_naive(uint32_t n)
+{
+    bigint ret = 1;
+    for (uint32_t i = 2; i <= n; ++i)
+        ret.mul_small(i);
+    return ret;
+}
+
+// C(n-k+i,i) = C(n-k+i-1,i-1)*(n-k+i)/i for i = 1..k for comparison
+static bigint _binomial_naive(uint32_t n, uint32_t k)
+{
+    if (k > n)
+        return 0;
+    k = std::min(k,n-k);
+    bigint ret = 1;
+    for (uint32_t i = 1; i <= k; ++i)
+    {
+        ret.mul_small(n-k+i);
+        const uint32_t r = ret.div_small(i);
+        assert(r == 0);
+        (void) r;
+    }
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    assert(big_factorial(0) == 1 && big_factorial(1) == 1);
+    assert(big_factorial(20).str() == "2432902008176640000");
+    assert(big_factorial(30).str() == "265252859812191058636308480000000");
+    assert(big_binomial(100,50).str() == "100891344545564193334812497256");
+    assert(big_binomial(5,6) == 0 && big_binomial(7,0) == 1);
+    for (uint32_t n = 0; n <= 300; ++n)
+        assert(big_factorial(n) == _factorial_naive(n));
+    for (uint32_t n : {1000,4096,10000})
+        assert(big_factorial(n) == _factorial_naive(n));
+    for (uint32_t n = 0; n <= 120; ++n)
+        for (uint32_t k = 0; k <= n+1; ++k)
+            assert(big_binomial(n,k) == _binomial_naive(n,k));
+    assert(big_binomial(20000,7000) == _binomial_naive(20000,7000));
+    // karatsuba against schoolbook on uneven sizes
+    {
+        uint64_t x = 1;
+        for (size_t an : {40,41,100,333,1000})
+            for (size_t bn : {40,77,1000,1500})
+            {
+                std::vector<uint32_t> a(an), b(bn), r1(an+bn), r2(an+bn);
+                for (uint32_t& v : a)
+                    v = (x = x*6364136223846793005ull + 1) >> 32;
+                for (uint32_t& v : b)
+                    v = (x = x*6364136223846793005ull + 1) >> 32 | 0xffff0000u;
+                _mul(a.data(),an,b.data(),bn,r1.data());
+                _mul_school(a.data(),an,b.data(),bn,r2.data());
+                assert(r1 == r2);
+            }
+    }
+
+    // run with "bench" argument for timing
+    if (argc > 1 && std::string(argv[1]) == "bench")
+    {
+        auto ms = [](auto s, auto t)
+        { return std::chrono::duration<double,std::milli>(t-s).count(); };
+        const uint32_t p = 1000000007;
+        for (uint32_t n : {10000,100000,1000000})
+        {
+            auto t0 = std::chrono::steady_clock::now();
+            const bigint f = big_factorial(n);
+            auto t1 = std::chrono::steady_clock::now();
+            const bigint c = big_binomial(n,n/2);
+            auto t2 = std::chrono::steady_clock::now();
+            printf("n = %u: n! (%zu bits) %.1f ms, C(n,n/2) %.1f ms",n,
+                32*f.d.size(),ms(t0,t1),ms(t1,t2));
+            if (n <= 100000)
+            {
+                t0 = std::chrono::steady_clock::now();
+                const bigint g = _factorial_naive(n);
+                t1 = std::chrono::steady_clock::now();
+                const bigint d = _binomial_naive(n,n/2);
+                t2 = std::chrono::steady_clock::now();
+                assert(f == g && c == d);
+                printf(", naive loops %.1f ms and %.1f ms",ms(t0,t1),ms(t1,t2));
+            }
+            else
+            {
+                // check modulo a prime
+                uint64_t fm = 1, km = 1;
+                for (uint32_t i = 2; i <= n; ++i)
+                    fm = fm * i % p;
+                for (uint32_t i = 2; i <= n/2; ++i)
+                    km = km * i % p;
+                assert(f.mod_small(p) == fm);
+                assert(c.mod_small(p) * km % p * km % p == fm);
+            }
+            printf("\n");
+        }
+    }
+}
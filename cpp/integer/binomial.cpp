@@ -0,0 +1,177 @@
+/*
+Overflow safe binomial coefficients for 64 bit results
+
+C(n,k) is built as C(n-k+i,i) = C(n-k+i-1,i-1)*(n-k+i)/i for i = 1..k (with
+k <= n-k). The intermediate values increase with i, so they are all at most
+the result, but the product before the division can exceed 64 bits (the
+templates in cpp_meta/combinations.cpp multiply in uint64_t and are wrong from
+C(63,31)). Here the product is a 128 bit integer, which is always exact since
+both factors are below 2^64, and the division is exact. binomial_gcd avoids
+128 bit arithmetic by dividing out g = gcd(r,i) first: i/g then divides
+n-k+i, so r/g*((n-k+i)/(i/g)) is the next value with one overflow check.
+
+binomial_checked reports whether the result fits in 64 bits, and
+binomial_saturating returns 2^64-1 when it does not. binomial requires the
+result to fit. All are constexpr and O(min(k,n-k)), an exact replacement for
+comb in py/exact_math/integer.py when the result is below 2^64.
+*/
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+typedef unsigned __int128 u128;
+
+// C(n,k) in out if it is below 2^64, otherwise false
+constexpr bool binomial_checked(uint64_t n, uint64_t k, uint64_t& out)
+{
+    out = 0;
+    if (k > n)
+        return true;
+    k = std::min(k,n-k);
+    u128 r = 1;
+    for (uint64_t i = 1; i <= k; ++i)
+    {
+        r = r * (n-k+i) / i;
+        if (r >> 64)
+            return false;
+    }
+    out = r;
+    return true;
+}
+
+// C(n,k) or 2^64-1 if it does not fit
+constexpr uint64_t binomial_saturating(uint64_t n, uint64_t k)
+{
+    uint64_t ret = 0;
+    return binomial_checked(n,k,ret) ? ret : ~0ull;
+}
+
+// C(n,k) which must fit in 64 bits
+constexpr uint64_t binomial(uint64_t n, uint64_t k)
+{
+    uint64_t ret = 0;
+    const bool ok = binomial_checked(n,k,ret);
+    assert(ok); // overflow
+    (void) ok;
+    return ret;
+}
+
+// same as binomial_checked without 128 bit arithmetic
+constexpr bool binomial_gcd(uint64_t n, uint64_t k, uint64_t& out)
+{
+    out = 0;
+    if (k > n)
+        return true;
+    k = std::min(k,n-k);
+    uint64_t r = 1;
+    for (uint64_t i = 1; i <= k; ++i)
+    {
+        const uint64_t g = std::gcd(r,i);
+        if (__builtin_mul_overflow(r/g,(n-k+i)/(i/g),&r))
+            return false;
+    }
+    out = r;
+    return true;
+}
+
+// compile time use
+static_assert(binomial(0,0) == 1 && binomial(5,6) == 0 && binomial(5,2) == 10);
+static_assert(binomial(62,31) == 465428353255261088ull);
+static_assert(binomial(63,31) == 916312070471295267ull);
+static_assert(binomial(67,33) == 14226520737620288370ull);
+static_assert(binomial_saturating(68,34) == ~0ull);
+static_assert(binomial_saturating(68,31) == ~0ull);
+static_assert(binomial(68,30) == 17876288714431443296ull);
+static_assert(binomial(~0ull,1) == ~0ull && binomial(~0ull,~0ull-1) == ~0ull);
+static_assert(binomial_saturating(~0ull,2) == ~0ull);
+static_assert(binomial(1ull << 32,2) == (1ull << 63) - (1ull << 31));
+
+// multiply first as in cpp_meta/combinations.cpp, for comparison
+static uint64_t _binomial_mulseq(uint64_t n, uint64_t k)
+{
+    if (k > n)
+        return 0;
+    k = std::min(k,n-k);
+    uint64_t r = 1;
+    for (uint64_t i = 1; i <= k; ++i)
+        r = r * (n-k+i) / i;
+    return r;
+}
+
+int main(int argc, char **argv)
+{
+    // pascal's triangle with values saturated at 2^64 (in 128 bits)
+    const u128 cap = (u128) 1 << 64;
+    std::vector<u128> row = {1};
+    for (uint64_t n = 0; n <= 2000; ++n)
+    {
+        for (uint64_t k = 0; k <= n+1; ++k)
+        {
+            const u128 c = k <= n ? row[k] : 0;
+            uint64_t a = 0, b = 0;
+            const bool fa = binomial_checked(n,k,a), fb = binomial_gcd(n,k,b);
+            assert(fa == (c < cap) && fb == fa);
+            if (fa)
+                assert(a == c && b == c && binomial(n,k) == c);
+            assert(binomial_saturating(n,k)
+                == (c < cap ? (uint64_t) c : ~0ull));
+        }
+        std::vector<u128> next(n+2);
+        next[0] = next[n+1] = 1;
+        for (uint64_t k = 1; k <= n; ++k)
+            next[k] = std::min(row[k-1] + row[k],cap);
+        row = next;
+    }
+    // large n with small k against 128 bit formulas
+    std::mt19937_64 rng(22);
+    for (int i = 0; i < 100000; ++i)
+    {
+        const uint64_t n = rng() >> (rng() % 64);
+        const u128 c2 = n < 2 ? 0 : (u128) n*(n-1)/2;
+        const u128 c3 = n < 3 ? 0 : (u128) n*(n-1)/2*(n-2)/3;
+        uint64_t a = 0, b = 0;
+        assert(binomial_checked(n,2,a) == (c2 < cap));
+        assert(binomial_gcd(n,2,b) == (c2 < cap));
+        assert(c2 >= cap || (a == c2 && b == c2));
+        if (n < (1ull << 42)) // n(n-1)(n-2) fits in 128 bits
+        {
+            assert(binomial_checked(n,3,a) == (c3 < cap));
+            assert(binomial_gcd(n,3,b) == (c3 < cap));
+            assert(c3 >= cap || (a == c3 && b == c3));
+            assert(binomial_checked(n,n-3,a) == (c3 < cap));
+        }
+    }
+    assert(_binomial_mulseq(63,31) != binomial(63,31)); // the overflow fixed
+
+    // run with "bench" argument for timing
+    if (argc > 1 && std::string(argv[1]) == "bench")
+    {
+        const int N = 10000000;
+        std::vector<uint64_t> ns(N), ks(N);
+        for (int i = 0; i < N; ++i)
+            ns[i] = rng() % 63, ks[i] = rng() % (ns[i]+1);
+        auto ms = [](auto s, auto t)
+        { return std::chrono::duration<double,std::milli>(t-s).count(); };
+        uint64_t s0 = 0, s1 = 0, s2 = 0, v = 0;
+        auto t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < N; ++i)
+            s0 += _binomial_mulseq(ns[i],ks[i]);
+        auto t1 = std::chrono::steady_clock::now();
+        for (int i = 0; i < N; ++i)
+            s1 += binomial_saturating(ns[i],ks[i]);
+        auto t2 = std::chrono::steady_clock::now();
+        for (int i = 0; i < N; ++i)
+            s2 += binomial_gcd(ns[i],ks[i],v) ? v : 0;
+        auto t3 = std::chrono::steady_clock::now();
+        assert(s0 == s1 && s1 == s2);
+        printf("%d binomials with n < 63: 64 bit (unsafe) %.1f ms, "
+            "128 bit %.1f ms, gcd %.1f ms\n",N,ms(t0,t1),ms(t1,t2),ms(t2,t3));
+    }
+}
@@ -0,0 +1,725 @@
+/*
+Fibonacci and Lucas numbers by fast doubling
+
+With a = F(k) and b = F(k+1),
+  F(2k) = a*(2b - a)    F(2k+1) = a^2 + b^2
+so F(n) takes O(log n) multiplications, processing the bits of n from the
+top. fibonacci_pair works for any type with +, - and * (uint64_t, where values
+wrap mod 2^64 and are exact for n <= 93; ModInt<P> copied from
+cpp/modint/modint.cpp; a runtime modulus; the bigint below) and is constexpr
+for the first two, unlike cpp_meta/fibonacci.cpp which instantiates a template
+per index up to 93. The Lucas numbers are L(n) = 2F(n+1) - F(n).
+
+The Pisano period pi(m) is the period of F(n) mod m, which is the lcm of
+pi(p^e) over the prime powers of m (factored with pollard rho copied from
+cpp/primes/pollard_rho.cpp). pi(p^e) divides p^(e-1)*pi(p), where pi(2) = 3,
+pi(5) = 20, pi(p) divides p-1 when p = +-1 mod 5 and 2(p+1) when p = +-2 mod 5.
+Starting from that multiple N, each prime q of N is divided out while N/q is
+still a period (F(N/q) = 0 and F(N/q+1) = 1 mod p^e).
+*/
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <numeric>
+#include <ostream>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+typedef unsigned __int128 u128;
+
+template <uint32_t P>
+class ModInt
+{
+    static_assert(P % 2 == 1 && P < (1u << 31),"P must be odd and below 2^31");
+
+    // -P^-1 mod 2^32 by newton iteration (each step doubles the correct bits)
+    static constexpr uint32_t _neg_inv()
+    {
+        uint32_t inv = P;
+        for (int i = 0; i < 4; ++i)
+            inv *= 2 - P*inv;
+        return -inv;
+    }
+
+    static constexpr uint32_t _NINV = _neg_inv();
+    static constexpr uint32_t _R2 = (uint32_t) (((__uint128_t) 1 << 64) % P);
+    uint32_t _v; // montgomery form, in [0,P)
+
+    // t*R^-1 mod P for t < P*2^32
+    static constexpr uint32_t _reduce(uint64_t t)
+    {
+        const uint32_t m = (uint32_t) t * _NINV;
+        const uint32_t r = (t + (uint64_t) m*P) >> 32; // < 2P
+        return r >= P ? r - P : r;
+    }
+
+    // integer to [0,P) including negative values
+    template <typename I>
+    static constexpr uint32_t _mod(I x)
+    {
+        static_assert(std::is_integral_v<I>);
+        if constexpr (std::is_signed_v<I>)
+        {
+            const int64_t r = (int64_t) x % (int64_t) P;
+            return r < 0 ? r + P : r;
+        }
+        else
+            return (uint64_t) x % P;
+    }
+
+    // value from montgomery form without conversion
+    static constexpr ModInt _raw(uint32_t v)
+    {
+        ModInt ret;
+        ret._v = v;
+        return ret;
+    }
+
+public:
+    constexpr ModInt(): _v(0) {}
+    template <typename I, typename = std::enable_if_t<std::is_integral_v<I>>>
+    constexpr ModInt(I x): _v(_reduce((uint64_t) _mod(x)*_R2)) {}
+
+    static constexpr uint32_t mod() { return P; }
+    // value in [0,P)
+    constexpr uint32_t val() const { return _reduce(_v); }
+    explicit constexpr operator uint32_t() const { return val(); }
+    explicit constexpr operator bool() const { return _v != 0; }
+
+    // arithmetic
+    constexpr ModInt& operator+=(const ModInt& o)
+    {
+        const uint32_t r = _v + o._v - P; // wraps below 0 when _v+o._v < P
+        _v = r + (-(r >> 31) & P);
+        return *this;
+    }
+    constexpr ModInt& operator-=(const ModInt& o)
+    {
+        const uint32_t r = _v - o._v;
+        _v = r + (-(r >> 31) & P);
+        return *this;
+    }
+    constexpr ModInt& operator*=(const ModInt& o)
+    {
+        _v = _reduce((uint64_t) _v*o._v);
+        return *this;
+    }
+    constexpr ModInt& operator/=(const ModInt& o) { return *this *= ~o; }
+
+    friend constexpr ModInt operator+(ModInt a, const ModInt& b)
+    { return a += b; }
+    friend constexpr ModInt operator-(ModInt a, const ModInt& b)
+    { return a -= b; }
+    friend constexpr ModInt operator*(ModInt a, const ModInt& b)
+    { return a *= b; }
+    friend constexpr ModInt operator/(ModInt a, const ModInt& b)
+    { return a /= b; }
+
+    constexpr ModInt operator+() const { return *this; }
+    constexpr ModInt operator-() const { return ModInt() - *this; }
+
+    // inverse with the extended euclidean algorithm (P may be composite)
+    constexpr ModInt operator~() const
+    {
+        assert(P > 1 && _v != 0); // 0 has no inverse
+        int64_t r0 = val(), r1 = P, s0 = 1, s1 = 0;
+        while (r1)
+        {
+            const int64_t q = r0/r1;
+            r0 -= q*r1;
+            s0 -= q*s1;
+            std::swap(r0,r1);
+            std::swap(s0,s1);
+        }
+        assert(r0 == 1); // not invertible
+        return ModInt(s0);
+    }
+
+    // power, negative exponents use the inverse
+    constexpr ModInt pow(int64_t e) const
+    {
+        ModInt b = e < 0 ? ~*this : *this, ret = _raw(_reduce(_R2));
+        uint64_t k = e < 0 ? -(uint64_t) e : e;
+        for (; k; k >>= 1, b *= b)
+            if (k & 1)
+                ret *= b;
+        return P == 1 ? ModInt() : ret;
+    }
+
+    // comparisons by value (montgomery form is a bijection so == is direct)
+    friend constexpr bool operator==(const ModInt& a, const ModInt& b)
+    { return a._v == b._v; }
+    friend constexpr bool operator!=(const ModInt& a, const ModInt& b)
+    { return a._v != b._v; }
+    friend constexpr bool operator<(const ModInt& a, const ModInt& b)
+    { return a.val() < b.val(); }
+    friend constexpr bool operator<=(const ModInt& a, const ModInt& b)
+    { return a.val() <= b.val(); }
+    friend constexpr bool operator>(const ModInt& a, const ModInt& b)
+    { return a.val() > b.val(); }
+    friend constexpr bool operator>=(const ModInt& a, const ModInt& b)
+    { return a.val() >= b.val(); }
+
+    friend std::ostream& operator<<(std::ostream& os, const ModInt& a)
+    { return os << a.val(); }
+};
+
+// high half of the full product a*b
+static inline uint64_t _mul_hi(uint64_t a, uint64_t b)
+{
+    return ((u128) a * b) >> 64;
+}
+
+static inline u128 _mul_hi(u128 a, u128 b)
+{
+    const uint64_t a0 = a, a1 = a >> 64, b0 = b, b1 = b >> 64;
+    const u128 p00 = (u128) a0*b0, p01 = (u128) a0*b1;
+    const u128 p10 = (u128) a1*b0, p11 = (u128) a1*b1;
+    const u128 mid = (p00 >> 64) + (uint64_t) p01 + (uint64_t) p10;
+    return p11 + (p01 >> 64) + (p10 >> 64) + (mid >> 64);
+}
+
+static inline int _ctz(uint64_t a) { return __builtin_ctzll(a); }
+
+static inline int _ctz(u128 a)
+{
+    return (uint64_t) a ? __builtin_ctzll(a) : 64 + __builtin_ctzll(a >> 64);
+}
+
+// binary gcd
+template <typename U>
+U _gcd(U a, U b)
+{
+    if (a == 0 || b == 0)
+        return a | b;
+    const int k = _ctz(a | b);
+    a >>= _ctz(a);
+    while (b)
+    {
+        b >>= _ctz(b);
+        if (a > b)
+            std::swap(a,b);
+        b -= a;
+    }
+    return a << k;
+}
+
+// montgomery arithmetic modulo odd n with R = 2^bits(U) (values in [0,n))
+template <typename U>
+struct _mont
+{
+    U n, inv, one, r2;
+
+    _mont(U n): n(n)
+    {
+        inv = n; // correct to 3 bits, newton doubles the correct bits
+        for (int i = 0; i < 7; ++i)
+            inv *= 2 - n*inv;
+        one = -n % n;
+        if constexpr (std::is_same_v<U,uint64_t>)
+            r2 = (u128) one * one % n;
+        else
+        {
+            r2 = one; // double R mod n another bits(U) times
+            for (int i = 0; i < 128; ++i)
+                r2 = r2 >= n - r2 ? r2 - (n - r2) : r2 + r2;
+        }
+    }
+
+    // a*b*R^-1 mod n
+    U mul(U a, U b) const
+    {
+        const U m = a*b*inv;
+        // low halves of a*b and m*n are equal so only high halves matter
+        const U hi = _mul_hi(a,b), mn = _mul_hi(m,n);
+        return hi >= mn ? hi - mn : hi - mn + n;
+    }
+
+    U add(U a, U b) const { return a >= n - b ? a - (n - b) : a + b; }
+    U sub(U a, U b) const { return a >= b ? a - b : a - b + n; }
+    U to(U a) const { return mul(a % n,r2); }
+
+    U pow(U a, U p) const
+    {
+        U ret = one;
+        for (; p; p >>= 1)
+        {
+            if (p & 1)
+                ret = mul(ret,a);
+            a = mul(a,a);
+        }
+        return ret;
+    }
+};
+
+// miller rabin for odd n > 2
+template <typename U>
+bool _miller_rabin(U n, std::initializer_list<uint64_t> bases)
+{
+    const _mont<U> m(n);
+    const int s = _ctz(n-1);
+    const U d = (n-1) >> s, mone = n - m.one;
+    for (uint64_t b : bases)
+    {
+        if (b % n == 0)
+            continue;
+        U x = m.pow(m.to(b),d);
+        if (x == m.one || x == mone)
+            continue;
+        int r = 1;
+        for (; r < s; ++r)
+        {
+            x = m.mul(x,x);
+            if (x == mone)
+                break;
+        }
+        if (r == s)
+            return false;
+    }
+    return true;
+}
+
+static constexpr uint32_t _SMALL_PRIMES[] = {2,3,5,7,11,13,17,19,23,29,31,37,
+    41,43,47,53,59,61,67,71,73,79,83,89,97};
+
+template <typename U>
+bool is_prime(U n)
+{
+    if (n < 2)
+        return false;
+    for (uint32_t p : _SMALL_PRIMES)
+        if (n % p == 0)
+            return n == p;
+    if (n < 97*97)
+        return true;
+    if (n >> 63 >> 1 == 0)
+        return _miller_rabin<uint64_t>(n,{2,325,9375,28178,450775,9780504,
+            1795265022});
+    return _miller_rabin<U>(n,{2,3,5,7,11,13,17,19,23,29,31,37,41,43,47,53,59,
+        61,67,71});
+}
+
+// nontrivial factor of odd composite n (n not a prime power of a small prime)
+template <typename U>
+U _pollard_brent(U n)
+{
+    const _mont<U> m(n);
+    const uint64_t M = 128; // differences multiplied per gcd
+    for (uint64_t c0 = 1;; ++c0)
+    {
+        const U c = m.to(c0);
+        auto f = [&](U x) { return m.add(m.mul(x,x),c); };
+        U x = m.one, y = x, ys = x, q = m.one, g = 1;
+        for (uint64_t r = 1; g == 1; r <<= 1)
+        {
+            x = y;
+            for (uint64_t i = 0; i < r; ++i)
+                y = f(y);
+            for (uint64_t k = 0; k < r && g == 1; k += M)
+            {
+                ys = y;
+                for (uint64_t i = 0; i < M && i < r-k; ++i)
+                {
+                    y = f(y);
+                    q = m.mul(q,m.sub(x,y));
+                }
+                // q is in montgomery form, gcd(q*R,n) = gcd(q,n)
+                g = _gcd(q,n);
+            }
+        }
+        if (g == n) // batch overshot, redo it one step at a time
+            do
+            {
+                ys = f(ys);
+                g = _gcd(m.sub(x,ys),n);
+            }
+            while (g == 1);
+        if (g != n)
+            return g;
+    }
+}
+
+template <typename U>
+void _factor_rec(U n, std::vector<U>& out)
+{
+    if (n == 1)
+        return;
+    if (is_prime(n))
+    {
+        out.push_back(n);
+        return;
+    }
+    if constexpr (!std::is_same_v<U,uint64_t>)
+        if (n >> 64 == 0) // faster 64 bit arithmetic
+        {
+            std::vector<uint64_t> f;
+            _factor_rec<uint64_t>(n,f);
+            out.insert(out.end(),f.begin(),f.end());
+            return;
+        }
+    const U d = _pollard_brent(n);
+    _factor_rec(d,out);
+    _factor_rec(n/d,out);
+}
+
+// prime factorization (increasing order with correct multiplicity)
+template <typename U>
+std::vector<U> _factorization(U n)
+{
+    assert(n > 0);
+    std::vector<U> ret;
+    if (n % 2 == 0)
+    {
+        const int e = _ctz(n);
+        ret.insert(ret.end(),e,2);
+        n >>= e;
+    }
+    // trial division by small odd integers
+    for (uint32_t d = 3; d < 1024 && (U) d*d <= n; d += 2)
+        while (n % d == 0)
+        {
+            ret.push_back(d);
+            n /= d;
+        }
+    if (n < 1024*1024)
+    {
+        if (n != 1)
+            ret.push_back(n);
+        return ret;
+    }
+    _factor_rec(n,ret);
+    std::sort(ret.begin(),ret.end());
+    return ret;
+}
+
+std::vector<uint64_t> factorization(uint64_t n)
+{
+    return _factorization(n);
+}
+
+// nonnegative big integer (32 bit limbs, least significant first, no leading
+// zero limbs) with the operations needed for fast doubling
+struct bigint
+{
+    std::vector<uint32_t> d;
+
+    bigint(uint64_t v = 0)
+    {
+        for (; v; v >>= 32)
+            d.push_back(v);
+    }
+
+    friend bigint operator+(const bigint& a, const bigint& b)
+    {
+        bigint ret;
+        const size_t n = std::max(a.d.size(),b.d.size());
+        ret.d.resize(n+1);
+        uint64_t c = 0;
+        for (size_t i = 0; i < n; ++i)
+        {
+            c += (uint64_t) (i < a.d.size() ? a.d[i] : 0)
+                + (i < b.d.size() ? b.d[i] : 0);
+            ret.d[i] = c;
+            c >>= 32;
+        }
+        ret.d[n] = c;
+        ret._trim();
+        return ret;
+    }
+
+    // a - b for a >= b
+    friend bigint operator-(const bigint& a, const bigint& b)
+    {
+        bigint ret = a;
+        int64_t c = 0;
+        for (size_t i = 0; i < a.d.size(); ++i)
+        {
+            c += (int64_t) a.d[i] - (i < b.d.size() ? b.d[i] : 0);
+            ret.d[i] = c;
+            c >>= 32; // 0 or -1
+        }
+        assert(c == 0); // a >= b
+        ret._trim();
+        return ret;
+    }
+
+    // schoolbook product
+    friend bigint operator*(const bigint& a, const bigint& b)
+    {
+        bigint ret;
+        if (a.d.empty() || b.d.empty())
+            return ret;
+        ret.d.resize(a.d.size()+b.d.size());
+        for (size_t i = 0; i < a.d.size(); ++i)
+        {
+            uint64_t c = 0;
+            for (size_t j = 0; j < b.d.size(); ++j)
+            {
+                c += (uint64_t) a.d[i]*b.d[j] + ret.d[i+j];
+                ret.d[i+j] = c;
+                c >>= 32;
+            }
+            ret.d[i+b.d.size()] = c;
+        }
+        ret._trim();
+        return ret;
+    }
+
+    friend bool operator==(const bigint& a, const bigint& b)
+    { return a.d == b.d; }
+
+    // decimal representation (quadratic)
+    std::string str() const
+    {
+        std::vector<uint32_t> v = d;
+        std::string ret;
+        while (!v.empty())
+        {
+            // divide by 10^9
+            uint64_t r = 0;
+            for (size_t i = v.size(); i--;)
+            {
+                r = r << 32 | v[i];
+                v[i] = r / 1000000000;
+                r %= 1000000000;
+            }
+            while (!v.empty() && v.back() == 0)
+                v.pop_back();
+            for (int j = 0; j < 9; ++j, r /= 10)
+                ret.push_back('0' + r % 10);
+        }
+        while (ret.size() > 1 && ret.back() == '0')
+            ret.pop_back();
+        if (ret.empty())
+            ret.push_back('0');
+        std::reverse(ret.begin(),ret.end());
+        return ret;
+    }
+
+private:
+    void _trim()
+    {
+        while (!d.empty() && d.back() == 0)
+            d.pop_back();
+    }
+};
+
+// (F(n),F(n+1)) by fast doubling, one is the multiplicative identity (for
+// types with a runtime modulus)
+template <typename T>
+constexpr std::pair<T,T> fibonacci_pair(uint64_t n, const T& one = T(1))
+{
+    T a = one - one, b = one; // F(k), F(k+1) for the top bits k of n
+    for (int i = std::bit_width(n); i--;)
+    {
+        const T c = a*(b+b-a), d = a*a + b*b; // F(2k), F(2k+1)
+        if (n >> i & 1)
+            a = d, b = c+d;
+        else
+            a = c, b = d;
+    }
+    return {a,b};
+}
+
+template <typename T>
+constexpr T fibonacci(uint64_t n, const T& one = T(1))
+{
+    return fibonacci_pair<T>(n,one).first;
+}
+
+template <typename T>
+constexpr T lucas(uint64_t n, const T& one = T(1))
+{
+    const auto [a,b] = fibonacci_pair<T>(n,one);
+    return b+b-a;
+}
+
+// integer modulo a runtime 64 bit modulus m >= 1
+struct _mod64
+{
+    uint64_t v, m;
+
+    friend _mod64 operator+(_mod64 a, _mod64 b)
+    { return {(uint64_t) (((u128) a.v + b.v) % a.m),a.m}; }
+    friend _mod64 operator-(_mod64 a, _mod64 b)
+    { return {a.v >= b.v ? a.v - b.v : a.v - b.v + a.m,a.m}; }
+    friend _mod64 operator*(_mod64 a, _mod64 b)
+    { return {(uint64_t) ((u128) a.v * b.v % a.m),a.m}; }
+};
+
+// F(n) mod m
+uint64_t fibonacci_mod(uint64_t n, uint64_t m)
+{
+    assert(m >= 1);
+    return fibonacci<_mod64>(n,{1 % m,m}).v;
+}
+
+// whether F(k+d) = F(k) mod m for all k
+static bool _is_fib_period(uint64_t d, uint64_t m)
+{
+    const auto [a,b] = fibonacci_pair<_mod64>(d,{1 % m,m});
+    return a.v == 0 && b.v == 1 % m;
+}
+
+// period of F(n) mod m (at most 6m), for 1 <= m < 2^61
+uint64_t pisano_period(uint64_t m)
+{
+    assert(m >= 1 && m < (1ull << 61));
+    const std::vector<uint64_t> f = factorization(m);
+    uint64_t ret = 1;
+    for (size_t i = 0, j; i < f.size(); i = j)
+    {
+        const uint64_t p = f[i];
+        uint64_t pe = 1;
+        for (j = i; j < f.size() && f[j] == p; ++j)
+            pe *= p;
+        // N = p^(e-1)*(multiple of pi(p)) is a period
+        const uint64_t n0 = p == 2 ? 3 : p == 5 ? 20
+            : (p % 5 == 1 || p % 5 == 4) ? p-1 : 2*(p+1);
+        uint64_t n = n0 * (pe/p);
+        std::vector<uint64_t> qs = factorization(n0);
+        qs.push_back(p);
+        for (uint64_t q : qs)
+            while (n % q == 0 && _is_fib_period(n/q,pe))
+                n /= q;
+        ret = std::lcm(ret,n);
+    }
+    return ret;
+}
+
+// compile time use
+static_assert(fibonacci<uint64_t>(0) == 0 && fibonacci<uint64_t>(1) == 1);
+static_assert(fibonacci<uint64_t>(93) == 12200160415121876738ull);
+static_assert(lucas<uint64_t>(0) == 2 && lucas<uint64_t>(10) == 123);
+static_assert(fibonacci<ModInt<1000000007>>(1000000000000000000ull)
+    == 209783453);
+static_assert(fibonacci<ModInt<998244353>>(1000000000000000000ull)
+    == 23849548);
+
+// period by iteration for testing
+static uint64_t _pisano_naive(uint64_t m)
+{
+    uint64_t a = 0, b = 1 % m, k = 0;
+    do
+    {
+        const uint64_t c = (a + b) % m;
+        a = b;
+        b = c;
+        ++k;
+    }
+    while (a != 0 || b != 1 % m);
+    return k;
+}
+
+int main(int argc, char **argv)
+{
+    // against iteration
+    uint64_t a = 0, b = 1;
+    bigint ba = 0, bb = 1;
+    ModInt<1000000007> ma = 0, mb = 1;
+    for (uint64_t n = 0; n < 1000; ++n)
+    {
+        assert(fibonacci<uint64_t>(n) == a && lucas<uint64_t>(n) == 2*b - a);
+        assert(fibonacci<bigint>(n) == ba);
+        assert(fibonacci<ModInt<1000000007>>(n) == ma);
+        assert(fibonacci_mod(n,1000000007) == ma.val());
+        assert(fibonacci_mod(n,1) == 0);
+        const uint64_t c = a + b;
+        a = b;
+        b = c;
+        const bigint bc = ba + bb;
+        ba = bb;
+        bb = bc;
+        const ModInt<1000000007> mc = ma + mb;
+        ma = mb;
+        mb = mc;
+    }
+    assert(fibonacci<bigint>(100).str() == "354224848179261915075");
+    assert(lucas<bigint>(100).str() == "792070839848372253127");
+    assert(bigint().str() == "0" && bigint(1000000000).str() == "1000000000");
+    // L(n)^2 = 5F(n)^2 + 4(-1)^n
+    for (uint64_t n : {5000,5001})
+    {
+        const bigint f = fibonacci<bigint>(n), l = lucas<bigint>(n);
+        if (n % 2)
+            assert(l*l + 4 == bigint(5)*f*f);
+        else
+            assert(l*l == bigint(5)*f*f + 4);
+    }
+
+    // pisano periods
+    assert(pisano_period(1) == 1 && pisano_period(2) == 3);
+    assert(pisano_period(10) == 60 && pisano_period(1000) == 1500);
+    assert(pisano_period(1000000007) == 2000000016);
+    for (uint64_t m = 1; m <= 3000; ++m)
+        assert(pisano_period(m) == _pisano_naive(m));
+    std::mt19937_64 rng(20);
+    for (int i = 0; i < 200; ++i)
+    {
+        const uint64_t m = (rng() >> (3 + rng() % 60)) + 1;
+        const uint64_t p = pisano_period(m), n = rng();
+        assert(_is_fib_period(p,m));
+        for (uint64_t q : factorization(p))
+            assert(!_is_fib_period(p/q,m));
+        assert(fibonacci_mod(n,m) == fibonacci_mod(n % p,m));
+    }
+
+    // run with "bench" argument for timing
+    if (argc > 1 && std::string(argv[1]) == "bench")
+    {
+        auto ms = [](auto s, auto t)
+        { return std::chrono::duration<double,std::milli>(t-s).count(); };
+        const int N = 1000000;
+        std::vector<uint64_t> ns(N);
+        for (uint64_t& n : ns)
+            n = rng() % 1000000000000000000ull;
+        auto t0 = std::chrono::steady_clock::now();
+        ModInt<1000000007> s = 0;
+        for (uint64_t n : ns)
+            s += fibonacci<ModInt<1000000007>>(n);
+        auto t1 = std::chrono::steady_clock::now();
+        uint64_t s2 = 0;
+        for (uint64_t n : ns)
+            s2 += fibonacci_mod(n,1000000007);
+        auto t2 = std::chrono::steady_clock::now();
+        assert(s2 % 1000000007 == s.val());
+        printf("%d F(n) for n < 10^18: ModInt %.1f ms, 64 bit runtime "
+            "modulus %.1f ms\n",N,ms(t0,t1),ms(t1,t2));
+        for (uint64_t n : {100000,1000000})
+        {
+            t0 = std::chrono::steady_clock::now();
+            const bigint f = fibonacci<bigint>(n);
+            t1 = std::chrono::steady_clock::now();
+            printf("F(%lu) (%zu bits): fast doubling %.1f ms",n,32*f.d.size(),
+                ms(t0,t1));
+            if (n <= 100000)
+            {
+                bigint x = 0, y = 1;
+                for (uint64_t k = 0; k < n; ++k)
+                {
+                    const bigint z = x + y;
+                    x = y;
+                    y = z;
+                }
+                t2 = std::chrono::steady_clock::now();
+                assert(x == f);
+                printf(", addition loop %.1f ms",ms(t1,t2));
+            }
+            printf("\n");
+        }
+        t0 = std::chrono::steady_clock::now();
+        uint64_t pp = 0;
+        for (int i = 0; i < 100; ++i)
+            pp += pisano_period((rng() >> 4) + 1) % 2;
+        t1 = std::chrono::steady_clock::now();
+        printf("100 pisano periods of 60 bit moduli %.1f ms\n",ms(t0,t1));
+        assert(pp <= 100);
+    }
+}
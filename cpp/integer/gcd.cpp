@@ -0,0 +1,295 @@
+/*
+Binary (Stein) gcd
+
+Replaces the divisions of the euclidean algorithm with count trailing zeros,
+shifts and subtraction. binary_gcd works for uint32_t, uint64_t and unsigned
+__int128.
+
+The batched versions (elementwise gcd of two arrays, gcd of a whole array) run
+8 lanes of uint32_t at a time with AVX2 when the cpu supports it (checked at
+runtime), otherwise the scalar code. AVX2 has no vector count trailing zeros,
+so it is computed from the float exponent of x & -x.
+*/
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <immintrin.h>
+
+typedef unsigned __int128 u128;
+
+// count trailing zeros (bit width for 0)
+static inline int _ctz(uint32_t a) { return std::countr_zero(a); }
+static inline int _ctz(uint64_t a) { return std::countr_zero(a); }
+
+static inline int _ctz(u128 a)
+{
+    return (uint64_t) a ? std::countr_zero((uint64_t) a)
+        : 64 + std::countr_zero((uint64_t) (a >> 64));
+}
+
+// greatest common divisor
+template <typename U>
+U binary_gcd(U a, U b)
+{
+    if (a == 0 || b == 0)
+        return a | b;
+    int az = _ctz(a);
+    const int bz = _ctz(b), k = std::min(az,bz);
+    b >>= bz;
+    while (a)
+    {
+        // b odd, a odd after the shift, continue with min and |difference|
+        // (trailing zeros of the difference are counted before the min so
+        // the two do not depend on each other)
+        a >>= az;
+        const U d = a > b ? a - b : b - a;
+        az = _ctz(d);
+        b = std::min(a,b);
+        a = d;
+    }
+    return b << k;
+}
+
+// lowest common multiple (0 if either is 0)
+template <typename U>
+U binary_lcm(U a, U b)
+{
+    const U g = binary_gcd(a,b);
+    return g == 0 ? 0 : a / g * b;
+}
+
+// elementwise out[i] = gcd(a[i],b[i])
+static void _gcd_pairs_scalar(const uint32_t *a, const uint32_t *b,
+    uint32_t *out, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+        out[i] = binary_gcd(a[i],b[i]);
+}
+
+// gcd of all elements, stopping early at 1
+static uint32_t _gcd_reduce_scalar(const uint32_t *a, size_t n)
+{
+    uint32_t g = 0;
+    for (size_t i = 0; i < n && g != 1; ++i)
+        g = binary_gcd(g,a[i]);
+    return g;
+}
+
+// count trailing zeros for each lane (x must be nonzero)
+__attribute__((target("avx2")))
+static inline __m256i _ctz_avx2(__m256i x)
+{
+    // lowest set bit is a power of 2 that converts exactly to float
+    // (2^31 converts as -2^31, the sign bit is removed by the mask)
+    const __m256i low = _mm256_and_si256(x,
+        _mm256_sub_epi32(_mm256_setzero_si256(),x));
+    const __m256i f = _mm256_castps_si256(_mm256_cvtepi32_ps(low));
+    return _mm256_sub_epi32(_mm256_and_si256(_mm256_srli_epi32(f,23),
+        _mm256_set1_epi32(0xff)),_mm256_set1_epi32(127));
+}
+
+// gcd of 8 lane pairs
+__attribute__((target("avx2")))
+static inline __m256i _gcd_avx2(__m256i a, __m256i b)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    // lanes with a zero input have result a|b, put it in a and set b = 0
+    const __m256i has0 = _mm256_or_si256(_mm256_cmpeq_epi32(a,zero),
+        _mm256_cmpeq_epi32(b,zero));
+    const __m256i ab = _mm256_or_si256(a,b);
+    a = _mm256_blendv_epi8(a,ab,has0);
+    b = _mm256_andnot_si256(has0,b);
+    const __m256i a_safe = _mm256_blendv_epi8(a,_mm256_set1_epi32(1),
+        _mm256_cmpeq_epi32(a,zero));
+    const __m256i k = _mm256_blendv_epi8(_ctz_avx2(_mm256_or_si256(a_safe,b)),
+        zero,has0);
+    a = _mm256_blendv_epi8(_mm256_srlv_epi32(a,_ctz_avx2(a_safe)),a,has0);
+    __m256i active = _mm256_cmpeq_epi32(_mm256_cmpeq_epi32(b,zero),zero);
+    while (!_mm256_testz_si256(active,active))
+    {
+        const __m256i b_safe = _mm256_or_si256(b,
+            _mm256_andnot_si256(active,_mm256_set1_epi32(1)));
+        const __m256i bs = _mm256_srlv_epi32(b_safe,_ctz_avx2(b_safe));
+        const __m256i lo = _mm256_min_epu32(a,bs);
+        const __m256i hi = _mm256_max_epu32(a,bs);
+        a = _mm256_blendv_epi8(a,lo,active);
+        b = _mm256_and_si256(_mm256_sub_epi32(hi,lo),active);
+        active = _mm256_cmpeq_epi32(_mm256_cmpeq_epi32(b,zero),zero);
+    }
+    return _mm256_sllv_epi32(a,k);
+}
+
+__attribute__((target("avx2")))
+static void _gcd_pairs_avx2(const uint32_t *a, const uint32_t *b,
+    uint32_t *out, size_t n)
+{
+    size_t i = 0;
+    for (; i+8 <= n; i += 8)
+    {
+        const __m256i va = _mm256_loadu_si256((const __m256i*) (a+i));
+        const __m256i vb = _mm256_loadu_si256((const __m256i*) (b+i));
+        _mm256_storeu_si256((__m256i*) (out+i),_gcd_avx2(va,vb));
+    }
+    _gcd_pairs_scalar(a+i,b+i,out+i,n-i);
+}
+
+__attribute__((target("avx2")))
+static uint32_t _gcd_reduce_avx2(const uint32_t *a, size_t n)
+{
+    __m256i g = _mm256_setzero_si256();
+    const __m256i ones = _mm256_set1_epi32(1);
+    size_t i = 0;
+    for (; i+8 <= n; i += 8)
+    {
+        g = _gcd_avx2(g,_mm256_loadu_si256((const __m256i*) (a+i)));
+        // all lanes 1 means the result is 1
+        if (i % 64 == 0 && _mm256_movemask_epi8(_mm256_cmpeq_epi32(g,ones))
+                == -1)
+            return 1;
+    }
+    alignas(32) uint32_t lanes[8];
+    _mm256_store_si256((__m256i*) lanes,g);
+    uint32_t ret = _gcd_reduce_scalar(lanes,8);
+    return binary_gcd(ret,_gcd_reduce_scalar(a+i,n-i));
+}
+
+static bool _has_avx2()
+{
+    static const bool ret = __builtin_cpu_supports("avx2");
+    return ret;
+}
+
+// elementwise out[i] = gcd(a[i],b[i]) for 0 <= i < n
+void gcd_pairs(const uint32_t *a, const uint32_t *b, uint32_t *out, size_t n)
+{
+    if (_has_avx2())
+        _gcd_pairs_avx2(a,b,out,n);
+    else
+        _gcd_pairs_scalar(a,b,out,n);
+}
+
+// gcd of a[0],..,a[n-1] (0 for n = 0)
+uint32_t gcd_reduce(const uint32_t *a, size_t n)
+{
+    return _has_avx2() ? _gcd_reduce_avx2(a,n) : _gcd_reduce_scalar(a,n);
+}
+
+int main(int argc, char **argv)
+{
+    // small values including zeros
+    for (uint32_t a = 0; a < 300; ++a)
+        for (uint32_t b = 0; b < 300; ++b)
+        {
+            assert(binary_gcd(a,b) == std::gcd(a,b));
+            assert(binary_gcd<uint64_t>(a,b) == std::gcd(a,b));
+            assert(binary_gcd<u128>(a,b) == std::gcd(a,b));
+            assert(binary_lcm(a,b) == std::lcm(a,b));
+        }
+    assert(binary_gcd(9u,72u) == 9 && binary_gcd(48u,32u) == 16);
+    assert(binary_lcm(72u,100u) == 1800);
+
+    std::mt19937_64 rng(1);
+    for (int i = 0; i < 100000; ++i)
+    {
+        const uint64_t a = rng() >> (rng() % 64), b = rng() >> (rng() % 64);
+        assert(binary_gcd(a,b) == std::gcd(a,b));
+        assert(binary_gcd<uint32_t>(a,b)
+            == std::gcd((uint32_t) a,(uint32_t) b));
+        const uint64_t c = rng() >> 40;
+        assert(binary_gcd((u128) a*c,(u128) b*c) == (u128) std::gcd(a,b)*c);
+    }
+    const u128 big = ~(u128) 0;
+    assert(binary_gcd(big,big/3) == big/3 && binary_gcd(big,(u128) 2) == 1);
+    assert(binary_gcd((u128) 1 << 127,(u128) 3 << 100) == (u128) 1 << 100);
+
+    // batched versions, with edge values and lengths not a multiple of 8
+    std::vector<uint32_t> a, b;
+    for (uint32_t x : {0u,1u,2u,3u,0x80000000u,0xffffffffu,0xfffffffeu,12u})
+        for (uint32_t y : {0u,1u,2u,6u,0x80000000u,0xffffffffu,0x40000000u,18u})
+            a.push_back(x), b.push_back(y);
+    for (int i = 0; i < 10003; ++i)
+    {
+        const uint32_t c = 1 + rng() % 1000;
+        a.push_back((rng() >> (32 + rng() % 32)) * c);
+        b.push_back((rng() >> (32 + rng() % 32)) * c);
+    }
+    std::vector<uint32_t> out(a.size()), expect(a.size());
+    gcd_pairs(a.data(),b.data(),out.data(),a.size());
+    _gcd_pairs_scalar(a.data(),b.data(),expect.data(),a.size());
+    assert(out == expect);
+    for (size_t i = 0; i < a.size(); ++i)
+        assert(out[i] == std::gcd(a[i],b[i]));
+    for (size_t n = 0; n < 40; ++n)
+    {
+        std::vector<uint32_t> v;
+        for (size_t i = 0; i < n; ++i)
+            v.push_back(360360u * (1 + rng() % 7) * (i == 5 ? 11 : 1));
+        uint32_t g = 0;
+        for (uint32_t x : v)
+            g = std::gcd(g,x);
+        assert(gcd_reduce(v.data(),n) == g);
+    }
+    assert(gcd_reduce(b.data(),b.size()) == 1);
+
+    // run with "bench" argument for timing
+    if (argc > 1 && std::string(argv[1]) == "bench")
+    {
+        const size_t N = 10000000;
+        std::vector<uint64_t> x(N), y(N);
+        for (size_t i = 0; i < N; ++i)
+            x[i] = rng(), y[i] = rng();
+        auto sec = [](auto s, auto t)
+        { return std::chrono::duration<double>(t-s).count(); };
+        uint64_t chk = 0;
+        auto t0 = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < N; ++i)
+            chk += std::gcd(x[i],y[i]);
+        auto t1 = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < N; ++i)
+            chk -= binary_gcd(x[i],y[i]);
+        auto t2 = std::chrono::steady_clock::now();
+        assert(chk == 0);
+        printf("uint64 %zu pairs: std::gcd %.3f sec, binary_gcd %.3f sec\n",
+            N,sec(t0,t1),sec(t1,t2));
+
+        std::vector<uint32_t> p(N), q(N), r(N);
+        for (size_t i = 0; i < N; ++i)
+            p[i] = x[i], q[i] = y[i];
+        t0 = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < N; ++i)
+            chk += std::gcd(p[i],q[i]);
+        t1 = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < N; ++i)
+            chk -= binary_gcd(p[i],q[i]);
+        t2 = std::chrono::steady_clock::now();
+        gcd_pairs(p.data(),q.data(),r.data(),N);
+        auto t3 = std::chrono::steady_clock::now();
+        assert(chk == 0);
+        printf("uint32 %zu pairs: std::gcd %.3f sec, binary_gcd %.3f sec, "
+            "gcd_pairs (avx2 %s) %.3f sec\n",N,sec(t0,t1),sec(t1,t2),
+            _has_avx2() ? "yes" : "no",sec(t2,t3));
+
+        // array reduction where the gcd stays large
+        for (size_t i = 0; i < N; ++i)
+            p[i] = 720720u * (1 + x[i] % 5000);
+        t0 = std::chrono::steady_clock::now();
+        uint32_t g = 0;
+        for (size_t i = 0; i < N; ++i)
+            g = std::gcd(g,p[i]);
+        t1 = std::chrono::steady_clock::now();
+        const uint32_t h = gcd_reduce(p.data(),N);
+        t2 = std::chrono::steady_clock::now();
+        assert(g == h);
+        printf("uint32 reduce %zu: std::gcd %.3f sec, gcd_reduce %.3f sec\n",
+            N,sec(t0,t1),sec(t1,t2));
+    }
+}
@@ -0,0 +1,307 @@
+/*
+Exact integer roots for 64 and 128 bit integers
+
+isqrt, icbrt and iroot (floor of the kth root) start from a floating point
+estimate (sqrt, cbrt, pow in double for 64 bits and long double for 128 bits)
+and correct it by +-1 steps using overflow safe integer checks, so the result
+is exact for every input. In constant evaluation (constexpr) the floating
+point functions are not usable, so integer newton iteration and bitwise search
+are used instead.
+
+perfect_power finds the largest exponent k with n = b^k by testing prime
+exponents p <= log2(n) (only those dividing the number of trailing zero bits
+when n is even) and recursing on the root.
+*/
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+typedef unsigned __int128 u128;
+
+// b^k <= n without overflow
+template <typename U>
+constexpr bool _pow_leq(U b, uint32_t k, U n)
+{
+    U v = 1;
+    for (uint32_t i = 0; i < k; ++i)
+        if (__builtin_mul_overflow(v,b,&v) || v > n)
+            return b == 0;
+    return true;
+}
+
+// largest r with r^k <= n, with r within a few steps of the estimate
+template <typename U>
+constexpr U _root_fix(U r, uint32_t k, U n)
+{
+    while (r > 0 && !_pow_leq(r,k,n))
+        --r;
+    while (r < std::numeric_limits<U>::max() && _pow_leq<U>(r+1,k,n))
+        ++r;
+    return r;
+}
+
+// floor(sqrt(n))
+template <typename U>
+constexpr U isqrt(U n)
+{
+    static_assert(std::is_same_v<U,uint64_t> || std::is_same_v<U,u128>);
+    if (n < 2)
+        return n;
+    constexpr U rmax = ((U) 1 << (4*sizeof(U))) - 1; // sqrt of the max value
+    if (std::is_constant_evaluated())
+    {
+        // newton iteration from above, as isqrt in py/exact_math/integer.py
+        U x0 = std::min<U>(n/2,rmax), x1 = (x0 + n/x0)/2;
+        while (x1 < x0)
+        {
+            x0 = x1;
+            x1 = (x0 + n/x0)/2;
+        }
+        return x0;
+    }
+    U r;
+    if constexpr (std::is_same_v<U,uint64_t>)
+        r = std::sqrt((double) n);
+    else
+        r = std::sqrt((long double) n);
+    r = std::min(r,rmax);
+    // r*r does not overflow since r <= rmax
+    while (r*r > n)
+        --r;
+    while (r < rmax && (r+1)*(r+1) <= n)
+        ++r;
+    return r;
+}
+
+// floor(n^(1/k)) for k >= 1
+template <typename U>
+constexpr U iroot(U n, uint32_t k)
+{
+    static_assert(std::is_same_v<U,uint64_t> || std::is_same_v<U,u128>);
+    assert(k >= 1);
+    if (n < 2 || k == 1)
+        return n;
+    if (k >= 8*sizeof(U)) // 2^k > n
+        return 1;
+    if (k == 2)
+        return isqrt(n);
+    if (std::is_constant_evaluated())
+    {
+        // bitwise method, as iroot in py/exact_math/integer.py
+        U ret = 1;
+        while (_pow_leq<U>(ret << 1,k,n))
+            ret <<= 1;
+        for (U bit = ret >> 1; bit; bit >>= 1)
+            if (_pow_leq<U>(ret | bit,k,n))
+                ret |= bit;
+        return ret;
+    }
+    // for 64 bits the root is below 2^22 so double precision is enough
+    U r;
+    if constexpr (std::is_same_v<U,uint64_t>)
+        r = k == 3 ? std::cbrt((double) n) : std::pow((double) n,1.0/k);
+    else
+        r = k == 3 ? std::cbrt((long double) n)
+            : std::pow((long double) n,1.0L/k);
+    return _root_fix<U>(r,k,n);
+}
+
+// floor(cbrt(n))
+template <typename U>
+constexpr U icbrt(U n)
+{
+    return iroot<U>(n,3);
+}
+
+// largest k >= 1 with n = b^k, returns k and sets b (k = 1 and b = n when n
+// is not a perfect power, including n < 4)
+template <typename U>
+uint32_t perfect_power(U n, U& b)
+{
+    b = n;
+    if (n < 4)
+        return 1;
+    // n = c^m (m maximal) is a perfect p-th power iff p divides m, so take the
+    // smallest such prime p and continue with the root
+    uint32_t log2;
+    if constexpr (sizeof(U) > 8)
+    {
+        const uint64_t hi = n >> 64;
+        // clz(0) is undefined, the low half is nonzero when hi = 0 and n >= 4
+        log2 = hi ? 127 - __builtin_clzll(hi)
+            : 63 - __builtin_clzll((uint64_t) n);
+    }
+    else
+        log2 = 63 - __builtin_clzll((uint64_t) n);
+    // the exponent of 2 in n is a multiple of m
+    uint32_t tz = 0;
+    while (!(n >> tz & 1))
+        ++tz;
+    for (uint32_t p : {2,3,5,7,11,13,17,19,23,29,31,37,41,43,47,53,59,61,67,
+            71,73,79,83,89,97,101,103,107,109,113,127})
+    {
+        if (p > log2)
+            break;
+        if (tz && tz % p)
+            continue;
+        const U r = iroot(n,p);
+        U v = 1;
+        for (uint32_t i = 0; i < p; ++i)
+            v *= r;
+        if (v == n)
+            return p * perfect_power(r,b);
+    }
+    return 1;
+}
+
+// constant evaluation
+static_assert(isqrt<uint64_t>(0) == 0);
+static_assert(isqrt<uint64_t>(15) == 3);
+static_assert(isqrt<uint64_t>(16) == 4);
+static_assert(isqrt<uint64_t>(~0ull) == 4294967295ull);
+static_assert(isqrt<u128>(~(u128) 0) == ~0ull);
+static_assert(icbrt<uint64_t>(~0ull) == 2642245);
+static_assert(icbrt<u128>(~(u128) 0) == 6981463658331ull);
+static_assert(iroot<uint64_t>(1000000000000000000ull,6) == 1000);
+static_assert(iroot<uint64_t>(999999999999999999ull,6) == 999);
+static_assert(iroot<uint64_t>(~0ull,63) == 2 && iroot<uint64_t>(~0ull,64) == 1);
+
+// bitwise method for comparison (as in py/exact_math/integer.py)
+template <typename U>
+static U _iroot_bitwise(U n, uint32_t k)
+{
+    if (n < 2 || k == 1)
+        return n;
+    U ret = 1;
+    while (ret << 1 != 0 && _pow_leq<U>(ret << 1,k,n))
+        ret <<= 1;
+    for (U bit = ret >> 1; bit; bit >>= 1)
+        if (_pow_leq<U>(ret | bit,k,n))
+            ret |= bit;
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    typedef uint64_t U;
+    assert(isqrt<U>(0) == 0 && isqrt<U>(1) == 1 && isqrt<U>(3) == 1);
+    for (U r = 0; r < 1000; ++r)
+        for (U n = r*r; n < (r+1)*(r+1); ++n)
+        {
+            assert(isqrt(n) == r && isqrt<u128>(n) == r);
+            assert(iroot(n,2) == r);
+        }
+    for (U r = 0; r < 100; ++r)
+        for (U n = r*r*r; n < (r+1)*(r+1)*(r+1); ++n)
+            assert(icbrt(n) == r && icbrt<u128>(n) == r);
+    for (U n = 0; n < 100; ++n)
+        assert(iroot<U>(n,1) == n);
+
+    // random and boundary values against the bitwise method
+    std::mt19937_64 rng(7);
+    for (int i = 0; i < 20000; ++i)
+    {
+        const uint32_t k = 2 + rng() % 70;
+        const U n = rng() >> (rng() % 64);
+        assert(iroot(n,k) == _iroot_bitwise(n,k));
+        const U r = iroot<U>(rng() >> 40,k % 6 + 2);
+        for (U v : {r,r+1})
+        {
+            U p = 1; // v^k and neighbours
+            for (uint32_t j = 0; j < k % 6 + 2; ++j)
+                p *= v;
+            for (U m : {p-1,p,p+1})
+                assert(iroot(m,k % 6 + 2) == _iroot_bitwise(m,k % 6 + 2));
+        }
+        const u128 w = ((u128) rng() << 64 | rng()) >> (rng() % 128);
+        assert(iroot(w,k) == _iroot_bitwise(w,k));
+        const u128 s = isqrt(w);
+        assert(s*s <= w && (s+1)*(s+1) > w);
+    }
+    assert(isqrt<U>(~0ull) == 4294967295ull);
+    assert(isqrt<U>(4294967295ull*4294967295ull) == 4294967295ull);
+    assert(isqrt<U>(4294967295ull*4294967295ull-1) == 4294967294ull);
+    assert(icbrt<U>(~0ull) == 2642245);
+    assert(isqrt<u128>(~(u128) 0) == ~0ull);
+    assert(isqrt<u128>((u128) ~0ull * ~0ull - 1) == ~0ull - 1);
+    assert(icbrt<u128>(~(u128) 0) == 6981463658331ull);
+    assert(iroot<u128>(~(u128) 0,127) == 2 && iroot<u128>(~(u128) 0,128) == 1);
+
+    // perfect powers
+    U b;
+    assert(perfect_power<U>(1ull << 62,b) == 62 && b == 2);
+    assert(perfect_power<U>(1000000000000000000ull,b) == 18 && b == 10);
+    assert(perfect_power<U>(1000000000000000001ull,b) == 1);
+    assert(perfect_power<U>(4738381338321616896ull,b) == 24 && b == 6);
+    assert(perfect_power<U>(18446744030759878681ull,b) == 2 && b == 4294967291ull);
+    assert(perfect_power<U>(12157665459056928801ull,b) == 40 && b == 3);
+    assert(perfect_power<U>(3,b) == 1 && perfect_power<U>(4,b) == 2 && b == 2);
+    assert(perfect_power<U>(216,b) == 3 && b == 6);
+    assert(perfect_power<U>(1296,b) == 4 && b == 6);
+    for (U n = 0; n < 100000; ++n)
+    {
+        const uint32_t k = perfect_power(n,b);
+        uint32_t best = 1;
+        for (uint32_t j = 2; j < 17; ++j)
+        {
+            const U r = _iroot_bitwise(n,j);
+            U v = 1;
+            for (uint32_t t = 0; t < j; ++t)
+                v *= r;
+            if (n >= 4 && v == n)
+                best = j;
+        }
+        assert(k == best);
+    }
+    u128 bw;
+    assert(perfect_power<u128>((u128) 1 << 127,bw) == 127 && bw == 2);
+    assert(perfect_power<u128>((u128) 1000000007*1000000007*1000000007,bw)
+        == 3 && bw == 1000000007);
+    assert(perfect_power<u128>(~(u128) 0,bw) == 1);
+
+    // run with "bench" argument for timing
+    if (argc > 1 && std::string(argv[1]) == "bench")
+    {
+        const int N = 10000000;
+        std::vector<U> v(N);
+        for (U& x : v)
+            x = rng();
+        auto sec = [](auto s, auto t)
+        { return std::chrono::duration<double>(t-s).count(); };
+        U chk = 0;
+        for (uint32_t k : {2,3,5})
+        {
+            auto t0 = std::chrono::steady_clock::now();
+            for (U x : v)
+                chk += iroot(x,k);
+            auto t1 = std::chrono::steady_clock::now();
+            for (U x : v)
+                chk -= _iroot_bitwise(x,k);
+            auto t2 = std::chrono::steady_clock::now();
+            printf("uint64 k=%u, %d roots: iroot %.3f sec, bitwise %.3f sec\n",
+                k,N,sec(t0,t1),sec(t1,t2));
+        }
+        auto t0 = std::chrono::steady_clock::now();
+        u128 chk2 = 0;
+        for (U x : v)
+            chk2 += isqrt((u128) x << 64 | x);
+        auto t1 = std::chrono::steady_clock::now();
+        printf("u128 %d isqrt: %.3f sec\n",N,sec(t0,t1));
+        t0 = std::chrono::steady_clock::now();
+        uint32_t pp = 0;
+        for (int i = 0; i < N/10; ++i)
+            pp += perfect_power(v[i] >> 20,b) > 1;
+        t1 = std::chrono::steady_clock::now();
+        printf("uint64 %d perfect_power: %.3f sec\n",N/10,sec(t0,t1));
+        assert(chk == 0 && chk2 != 1 && pp < N);
+    }
+}
@@ -0,0 +1,246 @@
+/*
+Binomial coefficients C(n,k) modulo any m for n up to 2^64
+
+binomial_mod(m) factors m < 2^32 and precomputes a table per prime power
+q = p^e of m, then each query is O(log n) multiplications per prime power:
+
+For e = 1 (lucas): C(n,k) = prod C(n_i,k_i) mod p over the base p digits
+n_i, k_i, with tables of i! and 1/i! mod p for i < p.
+
+For e > 1 (granville's generalization of lucas): write n! = p^v(n) * F(n)
+with v(n) = sum floor(n/p^j) (legendre) and F(n) coprime to p. With f(i) the
+product of the j <= i coprime to p (mod q), the multiples of p in n! contribute
+p^floor(n/p) * floor(n/p)! so
+  F(n) = f(q-1)^floor(n/q) * f(n mod q) * F(floor(n/p)) (mod q)
+where f(q-1) = -1 (or 1 when p = 2, e >= 3). Then
+  C(n,k) = p^(v(n)-v(k)-v(n-k)) * F(n)/(F(k)*F(n-k)) (mod q)
+which is 0 when the exponent is at least e, and the inverses come from a
+table of 1/f(i) built in the same sweep as f.
+
+The results modulo each p^e are combined by the chinese remainder theorem
+with coefficients (m/q)*((m/q)^-1 mod q) computed once (inverses by the
+extended euclidean algorithm, as modinv in py/exact_math/integer.py). The
+tables take O(sum p^e) memory, so m should have no large prime power factor.
+binomial_mod_cached keeps one object per modulus for repeated use.
+*/
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+typedef unsigned __int128 u128;
+
+// n^-1 mod m for gcd(n,m) = 1 (modinv in py/exact_math/integer.py)
+static uint64_t _modinv(uint64_t n, uint64_t m)
+{
+    assert(m > 1 && n % m != 0); // 0 has no inverse
+    int64_t r0 = n % m, r1 = m, s0 = 1, s1 = 0;
+    while (r1)
+    {
+        const int64_t q = r0/r1;
+        r0 -= q*r1;
+        s0 -= q*s1;
+        std::swap(r0,r1);
+        std::swap(s0,s1);
+    }
+    assert(r0 == 1); // not invertible
+    return s0 < 0 ? s0 + m : s0;
+}
+
+class binomial_mod
+{
+    // tables for one prime power q = p^e (values below q < 2^32)
+    struct _prime_power
+    {
+        uint64_t p, e, q;
+        // e = 1: i! and 1/i! for i < p, e > 1: f(i) and 1/f(i) for i < q
+        std::vector<uint32_t> f, inv_f;
+        bool neg; // f(q-1) = -1
+        uint64_t crt; // (m/q)*((m/q)^-1 mod q) mod m
+    };
+
+    uint64_t _m;
+    std::vector<_prime_power> _pp;
+
+    // F(n) (table t = f) or 1/F(n) (table t = inv_f) modulo q
+    static uint64_t _unit_fact(const _prime_power& pp,
+        const std::vector<uint32_t>& t, uint64_t n)
+    {
+        uint64_t r = 1;
+        bool neg = false;
+        for (; n; n /= pp.p)
+        {
+            neg ^= pp.neg && (n / pp.q) % 2;
+            r = r * t[n % pp.q] % pp.q;
+        }
+        return neg && r ? pp.q - r : r;
+    }
+
+    // exponent of p in n!
+    static uint64_t _legendre(uint64_t n, uint64_t p)
+    {
+        uint64_t v = 0;
+        for (n /= p; n; n /= p)
+            v += n;
+        return v;
+    }
+
+    static uint64_t _lucas(const _prime_power& pp, uint64_t n, uint64_t k)
+    {
+        const uint64_t p = pp.p;
+        uint64_t r = 1;
+        for (; k; n /= p, k /= p)
+        {
+            const uint64_t ni = n % p, ki = k % p;
+            if (ki > ni)
+                return 0;
+            r = r * pp.f[ni] % p * pp.inv_f[ki] % p * pp.inv_f[ni-ki] % p;
+        }
+        return r;
+    }
+
+    static uint64_t _granville(const _prime_power& pp, uint64_t n, uint64_t k)
+    {
+        const uint64_t v = _legendre(n,pp.p) - _legendre(k,pp.p)
+            - _legendre(n-k,pp.p);
+        if (v >= pp.e)
+            return 0;
+        uint64_t r = _unit_fact(pp,pp.f,n) * _unit_fact(pp,pp.inv_f,k) % pp.q
+            * _unit_fact(pp,pp.inv_f,n-k) % pp.q;
+        for (uint64_t i = 0; i < v; ++i)
+            r = r * pp.p % pp.q;
+        return r;
+    }
+
+public:
+    binomial_mod(uint64_t m): _m(m)
+    {
+        assert(m >= 1 && m < (1ull << 32));
+        // trial division is enough since the tables take O(p) anyway
+        for (uint64_t p = 2; m > 1; ++p)
+        {
+            if (p*p > m)
+                p = m;
+            if (m % p)
+                continue;
+            _prime_power pp{p,0,1,{},{},false,0};
+            while (m % p == 0)
+                m /= p, ++pp.e, pp.q *= p;
+            const uint64_t q = pp.q;
+            pp.f.resize(pp.e == 1 ? p : q);
+            pp.inv_f.resize(pp.f.size());
+            pp.f[0] = 1 % q;
+            for (uint64_t i = 1; i < pp.f.size(); ++i)
+                pp.f[i] = pp.e > 1 && i % p == 0 ? pp.f[i-1]
+                    : pp.f[i-1] * i % q;
+            // one inverse, then 1/f(i-1) = 1/f(i) * (i or 1)
+            const size_t last = pp.f.size()-1;
+            pp.inv_f[last] = q > 1 ? _modinv(pp.f[last],q) : 0;
+            for (uint64_t i = last; i > 0; --i)
+                pp.inv_f[i-1] = pp.e > 1 && i % p == 0 ? pp.inv_f[i]
+                    : pp.inv_f[i] * i % q;
+            pp.neg = pp.e > 1 && pp.f[q-1] == q-1 && q > 2;
+            const uint64_t mq = _m / q;
+            pp.crt = mq == 1 ? 1 : mq * _modinv(mq % q,q) % _m;
+            _pp.push_back(std::move(pp));
+        }
+    }
+
+    uint64_t mod() const { return _m; }
+
+    // C(n,k) mod m, 0 for k > n
+    uint64_t operator()(uint64_t n, uint64_t k) const
+    {
+        if (k > n || _m == 1)
+            return 0;
+        uint64_t ret = 0;
+        for (const _prime_power& pp : _pp)
+        {
+            const uint64_t r = pp.e == 1 ? _lucas(pp,n,k) : _granville(pp,n,k);
+            ret = (ret + (u128) r * pp.crt) % _m;
+        }
+        return ret;
+    }
+};
+
+// C(n,k) mod m reusing the tables of earlier calls with the same m
+uint64_t binomial_mod_cached(uint64_t n, uint64_t k, uint64_t m)
+{
+    static std::map<uint64_t,binomial_mod> cache;
+    auto it = cache.find(m);
+    if (it == cache.end())
+        it = cache.emplace(m,binomial_mod(m)).first;
+    return it->second(n,k);
+}
+
+int main(int argc, char **argv)
+{
+    // pascal's triangle modulo m
+    for (uint64_t m : {1,2,3,4,8,9,12,16,27,30,97,100,128,243,625,720,1001,
+        1024,142857,1000000})
+    {
+        const binomial_mod c(m);
+        std::vector<uint64_t> row = {1 % m};
+        for (uint64_t n = 0; n <= 300; ++n)
+        {
+            for (uint64_t k = 0; k <= n+1; ++k)
+                assert(c(n,k) == (k <= n ? row[k] : 0));
+            std::vector<uint64_t> next(n+2,1 % m);
+            for (uint64_t k = 1; k <= n; ++k)
+                next[k] = (row[k-1] + row[k]) % m;
+            row = next;
+        }
+    }
+    // large n: pascal's rule and symmetry
+    std::mt19937_64 rng(24);
+    for (uint64_t m : {2,7,64,81,1000,999983,1000000})
+    {
+        const binomial_mod c(m);
+        for (int i = 0; i < 20000; ++i)
+        {
+            const uint64_t n = (rng() >> (rng() % 64)) + 1;
+            const uint64_t k = rng() % (n+1);
+            assert(c(n,k) == c(n,n-k));
+            if (k > 0)
+                assert(c(n,k) == (c(n-1,k-1) + c(n-1,k)) % m);
+        }
+    }
+    // known values (from python math.comb)
+    const uint64_t e18 = 1000000000000000000ull;
+    assert(binomial_mod(1009)(e18,3) == 51 && binomial_mod(10)(e18,1) == 0);
+    assert(binomial_mod(1000)(e18,2) == 0 && binomial_mod(27)(27,9) == 3);
+    assert(binomial_mod(82944)(123456789,12345) == 31104);
+    assert(binomial_mod(12)(10,5) == 0 && binomial_mod(7)(10,3) == 120 % 7);
+    assert(binomial_mod_cached(10,5,1000) == 252);
+    assert(binomial_mod_cached(10,5,1000) == 252);
+    assert(binomial_mod_cached(100,50,97) == binomial_mod(97)(100,50));
+
+    // run with "bench" argument for timing
+    if (argc > 1 && std::string(argv[1]) == "bench")
+    {
+        const int Q = 1000000;
+        std::vector<uint64_t> ns(Q), ks(Q);
+        for (int i = 0; i < Q; ++i)
+            ns[i] = rng() % 1000000000000000001ull, ks[i] = rng() % (ns[i]+1);
+        auto ms = [](auto s, auto t)
+        { return std::chrono::duration<double,std::milli>(t-s).count(); };
+        for (uint64_t m : {999983,1000000,1048576,142857})
+        {
+            auto t0 = std::chrono::steady_clock::now();
+            const binomial_mod c(m);
+            auto t1 = std::chrono::steady_clock::now();
+            uint64_t s = 0;
+            for (int i = 0; i < Q; ++i)
+                s += c(ns[i],ks[i]);
+            auto t2 = std::chrono::steady_clock::now();
+            printf("m = %lu: tables %.1f ms, %d queries with n < 10^18 %.1f ms "
+                "(%lu)\n",m,ms(t0,t1),Q,ms(t1,t2),s % 10);
+        }
+    }
+}
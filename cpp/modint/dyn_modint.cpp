@@ -0,0 +1,293 @@
+/*
+Modular integer with a runtime modulus using barrett reduction
+
+DynModInt<ID> keeps its modulus 1 <= m < 2^32 in a static context shared by
+all values with the same ID (set once with set_mod, like MOD_DEFAULT in
+py/exact_math/modint.py but checked once instead of per object). Different IDs
+give independent moduli in the same program.
+
+The context stores im = floor((2^64-1)/m). For any z < 2^64,
+x = floor(z*im/2^64) is the quotient floor(z/m) or one less, so z - x*m is the
+remainder or the remainder plus m, fixed with one conditional subtraction. This reduces products and
+arbitrary 64 bit inputs with two multiplications and no division (only the
+inverse uses the euclidean algorithm).
+
+The operators mirror ModInt in py/exact_math/modint.py, as for ModInt<P>.
+*/
+
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <numeric>
+#include <ostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+typedef unsigned __int128 u128;
+
+// barrett reduction for a modulus 1 <= m < 2^32
+struct barrett
+{
+    uint32_t m;
+    uint64_t im; // floor((2^64-1)/m)
+
+    barrett(uint32_t m): m(m), im(~0ull/m) { assert(m >= 1); }
+
+    // z mod m for any 64 bit z
+    uint32_t reduce(uint64_t z) const
+    {
+        const uint64_t x = (uint64_t) (((u128) z*im) >> 64);
+        uint64_t v = z - x*m; // in [0,2m)
+        if (v >= m)
+            v -= m;
+        return v;
+    }
+
+    uint32_t mul(uint32_t a, uint32_t b) const
+    {
+        return reduce((uint64_t) a*b);
+    }
+};
+
+template <int ID>
+class DynModInt
+{
+    static inline barrett _ctx{1};
+    uint32_t _v; // in [0,m)
+
+    template <typename I>
+    static uint32_t _mod(I x)
+    {
+        static_assert(std::is_integral_v<I>);
+        if constexpr (std::is_signed_v<I>)
+        {
+            if (x < 0)
+            {
+                const uint32_t r = _ctx.reduce(-(uint64_t) (int64_t) x);
+                return r ? _ctx.m - r : 0;
+            }
+        }
+        return _ctx.reduce((uint64_t) x);
+    }
+
+    static DynModInt _raw(uint32_t v)
+    {
+        DynModInt ret;
+        ret._v = v;
+        return ret;
+    }
+
+public:
+    // sets the modulus for all values with this ID (existing values are not
+    // converted so they should not be used afterward)
+    static void set_mod(uint32_t m) { _ctx = barrett(m); }
+    static uint32_t mod() { return _ctx.m; }
+
+    DynModInt(): _v(0) {}
+    template <typename I, typename = std::enable_if_t<std::is_integral_v<I>>>
+    DynModInt(I x): _v(_mod(x)) {}
+
+    uint32_t val() const { return _v; }
+    explicit operator uint32_t() const { return _v; }
+    explicit operator bool() const { return _v != 0; }
+
+    // arithmetic (64 bit sums since m may exceed 2^31)
+    DynModInt& operator+=(const DynModInt& o)
+    {
+        const uint64_t r = (uint64_t) _v + o._v - _ctx.m;
+        _v = r + (-(r >> 63) & _ctx.m);
+        return *this;
+    }
+    DynModInt& operator-=(const DynModInt& o)
+    {
+        const uint64_t r = (uint64_t) _v - o._v;
+        _v = r + (-(r >> 63) & _ctx.m);
+        return *this;
+    }
+    DynModInt& operator*=(const DynModInt& o)
+    {
+        _v = _ctx.mul(_v,o._v);
+        return *this;
+    }
+    DynModInt& operator/=(const DynModInt& o) { return *this *= ~o; }
+
+    friend DynModInt operator+(DynModInt a, const DynModInt& b)
+    { return a += b; }
+    friend DynModInt operator-(DynModInt a, const DynModInt& b)
+    { return a -= b; }
+    friend DynModInt operator*(DynModInt a, const DynModInt& b)
+    { return a *= b; }
+    friend DynModInt operator/(DynModInt a, const DynModInt& b)
+    { return a /= b; }
+
+    DynModInt operator+() const { return *this; }
+    DynModInt operator-() const { return DynModInt() - *this; }
+
+    // inverse with the extended euclidean algorithm
+    DynModInt operator~() const
+    {
+        assert(_ctx.m > 1 && _v != 0); // 0 has no inverse
+        int64_t r0 = _v, r1 = _ctx.m, s0 = 1, s1 = 0;
+        while (r1)
+        {
+            const int64_t q = r0/r1;
+            r0 -= q*r1;
+            s0 -= q*s1;
+            std::swap(r0,r1);
+            std::swap(s0,s1);
+        }
+        assert(r0 == 1); // not invertible
+        return DynModInt(s0);
+    }
+
+    // power, negative exponents use the inverse
+    DynModInt pow(int64_t e) const
+    {
+        DynModInt b = e < 0 ? ~*this : *this, ret = _raw(_mod(1));
+        for (uint64_t k = e < 0 ? -(uint64_t) e : e; k; k >>= 1, b *= b)
+            if (k & 1)
+                ret *= b;
+        return ret;
+    }
+
+    friend bool operator==(const DynModInt& a, const DynModInt& b)
+    { return a._v == b._v; }
+    friend bool operator!=(const DynModInt& a, const DynModInt& b)
+    { return a._v != b._v; }
+    friend bool operator<(const DynModInt& a, const DynModInt& b)
+    { return a._v < b._v; }
+    friend bool operator<=(const DynModInt& a, const DynModInt& b)
+    { return a._v <= b._v; }
+    friend bool operator>(const DynModInt& a, const DynModInt& b)
+    { return a._v > b._v; }
+    friend bool operator>=(const DynModInt& a, const DynModInt& b)
+    { return a._v >= b._v; }
+
+    friend std::ostream& operator<<(std::ostream& os, const DynModInt& a)
+    { return os << a._v; }
+};
+
+int main(int argc, char **argv)
+{
+    // tests from py/exact_math/modint.py
+    typedef DynModInt<0> MI;
+    auto M = [](int64_t n, uint32_t m) { MI::set_mod(m); return MI(n); };
+    assert(M(0,1).val() == 0 && MI::mod() == 1 && M(4,15).val() == 4);
+    assert(M(-4,15).val() == 11 && M(62,15).val() == 2);
+    std::ostringstream ss;
+    ss << M(-1,1) << ' ' << M(-3,12) << ' ' << M(16,11) << ' ' << M(-100,14);
+    assert(ss.str() == "0 9 5 12");
+    MI::set_mod(7);
+    assert(MI(5) == 5 && MI(5) == -2 && MI(5) == 12 && MI(6) != 7);
+    MI::set_mod(10);
+    assert(MI(-3) == 7 && MI(-3) == 17 && MI(-3) == MI(27));
+    assert(!(MI(5) < 4) && !(MI(5) < 5) && MI(5) < 6 && MI(5) <= 5);
+    assert(MI(5) > 4 && !(MI(5) > 5) && MI(5) >= 5 && !(MI(5) >= 6));
+    assert(MI(7) + MI(4) == 1 && !MI(0) && MI(3));
+    MI::set_mod(30);
+    assert(-MI(12) == 18 && +MI(9) == 9);
+    MI::set_mod(24);
+    assert(~MI(5) == 5);
+    MI::set_mod(12);
+    assert(MI(-1) * MI(8) == 4);
+    MI::set_mod(18);
+    assert(MI(5) * 2 == 10 && MI(5) * 0 == 0 && MI(5) * (-3) == 3);
+    MI::set_mod(9);
+    assert(MI(3) / MI(2) == 6 && -1 / MI(2) == 4);
+    MI::set_mod(8);
+    assert(3 + MI(5) == 0 && -6 + MI(5) == 7);
+    MI::set_mod(14);
+    assert(12 - MI(4) == 8 && -3 - MI(4) == 7);
+    MI::set_mod(6);
+    assert(-2 * MI(4) == 4 && 3 * MI(3) == 3);
+    MI::set_mod(15);
+    assert(MI(1).pow(10) == 1 && MI(4).pow(-1) == 4 && MI(7).pow(-2) == 4);
+    MI::set_mod(17);
+    assert(MI(12).pow(-2) == -2 && MI(12).pow(-16) == 1);
+    MI::set_mod(20);
+    assert(MI(7).pow(8) == 1);
+    MI::set_mod(1);
+    assert(MI(0).pow(5790) == 0 && MI(0).pow(0) == 0);
+
+    // independent contexts
+    DynModInt<1>::set_mod(1000000007);
+    DynModInt<2>::set_mod(998244353);
+    assert(DynModInt<1>(-1).val() == 1000000006);
+    assert(DynModInt<2>(-1).val() == 998244352);
+
+    // random operations against 64 bit arithmetic, including m >= 2^31 and
+    // 64 bit inputs
+    std::mt19937_64 rng(5);
+    for (uint64_t p : std::vector<uint64_t>{1,2,3,1000000007,998244353,
+        2147483648,4294967291,4294967295,(rng() >> 32) | 1,(rng() >> 48) + 1})
+    {
+        MI::set_mod(p);
+        for (int i = 0; i < 100000; ++i)
+        {
+            const uint64_t a = rng() % p, b = rng() % p, z = rng();
+            const int64_t s = rng();
+            const MI x = a, y = b;
+            assert(MI(z).val() == z % p);
+            assert(MI(s).val() == (uint64_t) ((s % (int64_t) p + p) % p));
+            assert((x+y).val() == (a+b) % p);
+            assert((x-y).val() == (a+p-b) % p);
+            assert((x*y).val() == a*b % p);
+            if (i < 1000)
+            {
+                const int64_t e = rng() % 1000;
+                uint64_t q = 1 % p;
+                for (int64_t j = 0; j < e; ++j)
+                    q = q*a % p;
+                assert(x.pow(e).val() == q);
+            }
+            if (p > 1 && std::gcd(b,p) == 1)
+                assert((x/y*y).val() == a);
+        }
+    }
+
+    // run with "bench" argument for timing
+    if (argc > 1 && std::string(argv[1]) == "bench")
+    {
+        volatile uint32_t vp = 1000000007;
+        const uint64_t p = vp;
+        MI::set_mod(p);
+        const int N = 1 << 12, R = 50000;
+        std::vector<uint64_t> a(N), c(N);
+        std::vector<MI> b(N), d(N);
+        for (int i = 0; i < N; ++i)
+            b[i] = a[i] = rng() % p;
+        auto sec = [](auto s, auto t)
+        { return std::chrono::duration<double>(t-s).count(); };
+        const double ops = (double) R*N;
+        auto t0 = std::chrono::steady_clock::now();
+        for (int r = 0; r < R; ++r)
+            for (int i = 1; i < N; ++i)
+                a[i] = a[i]*a[i-1] % p;
+        auto t1 = std::chrono::steady_clock::now();
+        for (int r = 0; r < R; ++r)
+            for (int i = 1; i < N; ++i)
+                b[i] *= b[i-1];
+        auto t2 = std::chrono::steady_clock::now();
+        for (int i = 0; i < N; ++i)
+            assert(b[i] == a[i]);
+        printf("%g dependent mulmod: %% %.3f sec, barrett %.3f sec\n",
+            ops,sec(t0,t1),sec(t1,t2));
+        t0 = std::chrono::steady_clock::now();
+        for (int r = 0; r < R; ++r)
+            for (int i = 0; i < N; ++i)
+                c[i] = (c[i] + a[i]*a[(i+r)%N]) % p;
+        t1 = std::chrono::steady_clock::now();
+        for (int r = 0; r < R; ++r)
+            for (int i = 0; i < N; ++i)
+                d[i] += b[i]*b[(i+r)%N];
+        t2 = std::chrono::steady_clock::now();
+        for (int i = 0; i < N; ++i)
+            assert(d[i] == c[i]);
+        printf("%g independent multiply add: %% %.3f sec, barrett %.3f sec\n",
+            ops,sec(t0,t1),sec(t1,t2));
+    }
+}
@@ -0,0 +1,316 @@
+/*
+Factorial and inverse factorial tables for binomials modulo a prime
+
+factorial_table<M> stores n! and 1/n! for n <= N over a modular type M (such
+as ModInt<P>, copied from cpp/modint/modint.cpp) with N < p. The factorials are
+a running product and only N! is inverted (extended euclidean algorithm), then
+1/(n-1)! = n * 1/n! down to 0, so building is O(N) multiplications and one
+inverse. Then each query is O(1) multiplications:
+  C(n,k) = n!/(k!(n-k)!)      P(n,k) = n!/(n-k)!      1/n = (n-1)!/n!
+  multinomial(k_1,..,k_m) = (k_1+..+k_m)!/(k_1!..k_m!)
+instead of the exact integers of comb and perm in py/exact_math/integer.py
+and cpp_meta/combinations.cpp, cpp_meta/permutations.cpp.
+*/
+
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <initializer_list>
+#include <ostream>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+template <uint32_t P>
+class ModInt
+{
+    static_assert(P % 2 == 1 && P < (1u << 31),"P must be odd and below 2^31");
+
+    // -P^-1 mod 2^32 by newton iteration (each step doubles the correct bits)
+    static constexpr uint32_t _neg_inv()
+    {
+        uint32_t inv = P;
+        for (int i = 0; i < 4; ++i)
+            inv *= 2 - P*inv;
+        return -inv;
+    }
+
+    static constexpr uint32_t _NINV = _neg_inv();
+    static constexpr uint32_t _R2 = (uint32_t) (((__uint128_t) 1 << 64) % P);
+    uint32_t _v; // montgomery form, in [0,P)
+
+    // t*R^-1 mod P for t < P*2^32
+    static constexpr uint32_t _reduce(uint64_t t)
+    {
+        const uint32_t m = (uint32_t) t * _NINV;
+        const uint32_t r = (t + (uint64_t) m*P) >> 32; // < 2P
+        return r >= P ? r - P : r;
+    }
+
+    // integer to [0,P) including negative values
+    template <typename I>
+    static constexpr uint32_t _mod(I x)
+    {
+        static_assert(std::is_integral_v<I>);
+        if constexpr (std::is_signed_v<I>)
+        {
+            const int64_t r = (int64_t) x % (int64_t) P;
+            return r < 0 ? r + P : r;
+        }
+        else
+            return (uint64_t) x % P;
+    }
+
+    // value from montgomery form without conversion
+    static constexpr ModInt _raw(uint32_t v)
+    {
+        ModInt ret;
+        ret._v = v;
+        return ret;
+    }
+
+public:
+    constexpr ModInt(): _v(0) {}
+    template <typename I, typename = std::enable_if_t<std::is_integral_v<I>>>
+    constexpr ModInt(I x): _v(_reduce((uint64_t) _mod(x)*_R2)) {}
+
+    static constexpr uint32_t mod() { return P; }
+    // value in [0,P)
+    constexpr uint32_t val() const { return _reduce(_v); }
+    explicit constexpr operator uint32_t() const { return val(); }
+    explicit constexpr operator bool() const { return _v != 0; }
+
+    // arithmetic
+    constexpr ModInt& operator+=(const ModInt& o)
+    {
+        const uint32_t r = _v + o._v - P; // wraps below 0 when _v+o._v < P
+        _v = r + (-(r >> 31) & P);
+        return *this;
+    }
+    constexpr ModInt& operator-=(const ModInt& o)
+    {
+        const uint32_t r = _v - o._v;
+        _v = r + (-(r >> 31) & P);
+        return *this;
+    }
+    constexpr ModInt& operator*=(const ModInt& o)
+    {
+        _v = _reduce((uint64_t) _v*o._v);
+        return *this;
+    }
+    constexpr ModInt& operator/=(const ModInt& o) { return *this *= ~o; }
+
+    friend constexpr ModInt operator+(ModInt a, const ModInt& b)
+    { return a += b; }
+    friend constexpr ModInt operator-(ModInt a, const ModInt& b)
+    { return a -= b; }
+    friend constexpr ModInt operator*(ModInt a, const ModInt& b)
+    { return a *= b; }
+    friend constexpr ModInt operator/(ModInt a, const ModInt& b)
+    { return a /= b; }
+
+    constexpr ModInt operator+() const { return *this; }
+    constexpr ModInt operator-() const { return ModInt() - *this; }
+
+    // inverse with the extended euclidean algorithm (P may be composite)
+    constexpr ModInt operator~() const
+    {
+        assert(P > 1 && _v != 0); // 0 has no inverse
+        int64_t r0 = val(), r1 = P, s0 = 1, s1 = 0;
+        while (r1)
+        {
+            const int64_t q = r0/r1;
+            r0 -= q*r1;
+            s0 -= q*s1;
+            std::swap(r0,r1);
+            std::swap(s0,s1);
+        }
+        assert(r0 == 1); // not invertible
+        return ModInt(s0);
+    }
+
+    // power, negative exponents use the inverse
+    constexpr ModInt pow(int64_t e) const
+    {
+        ModInt b = e < 0 ? ~*this : *this, ret = _raw(_reduce(_R2));
+        uint64_t k = e < 0 ? -(uint64_t) e : e;
+        for (; k; k >>= 1, b *= b)
+            if (k & 1)
+                ret *= b;
+        return P == 1 ? ModInt() : ret;
+    }
+
+    // comparisons by value (montgomery form is a bijection so == is direct)
+    friend constexpr bool operator==(const ModInt& a, const ModInt& b)
+    { return a._v == b._v; }
+    friend constexpr bool operator!=(const ModInt& a, const ModInt& b)
+    { return a._v != b._v; }
+    friend constexpr bool operator<(const ModInt& a, const ModInt& b)
+    { return a.val() < b.val(); }
+    friend constexpr bool operator<=(const ModInt& a, const ModInt& b)
+    { return a.val() <= b.val(); }
+    friend constexpr bool operator>(const ModInt& a, const ModInt& b)
+    { return a.val() > b.val(); }
+    friend constexpr bool operator>=(const ModInt& a, const ModInt& b)
+    { return a.val() >= b.val(); }
+
+    friend std::ostream& operator<<(std::ostream& os, const ModInt& a)
+    { return os << a.val(); }
+};
+
+// n! and 1/n! for n <= N modulo a prime p > N
+template <typename M>
+class factorial_table
+{
+    std::vector<M> _fact, _inv_fact;
+
+public:
+    factorial_table(size_t n): _fact(n+1), _inv_fact(n+1)
+    {
+        assert(n < M::mod()); // n! must be invertible
+        _fact[0] = 1;
+        for (size_t i = 1; i <= n; ++i)
+            _fact[i] = _fact[i-1] * i;
+        _inv_fact[n] = ~_fact[n];
+        for (size_t i = n; i > 0; --i)
+            _inv_fact[i-1] = _inv_fact[i] * i;
+    }
+
+    size_t size() const { return _fact.size(); }
+    // n! and 1/n! for n <= N
+    M fact(size_t n) const
+    {
+        assert(n < _fact.size());
+        return _fact[n];
+    }
+    M inv_fact(size_t n) const
+    {
+        assert(n < _fact.size());
+        return _inv_fact[n];
+    }
+    // 1/n for 1 <= n <= N
+    M inv(size_t n) const
+    {
+        assert(n >= 1 && n < _fact.size());
+        return _inv_fact[n] * _fact[n-1];
+    }
+
+    // C(n,k) for n <= N, 0 for k > n
+    M comb(size_t n, size_t k) const
+    {
+        assert(n < _fact.size());
+        if (k > n)
+            return 0;
+        return _fact[n] * _inv_fact[k] * _inv_fact[n-k];
+    }
+
+    // n!/(n-k)! for n <= N, 0 for k > n
+    M perm(size_t n, size_t k) const
+    {
+        assert(n < _fact.size());
+        if (k > n)
+            return 0;
+        return _fact[n] * _inv_fact[n-k];
+    }
+
+    // (k_1+..+k_m)!/(k_1!..k_m!), the sum must be at most N
+    M multinomial(std::initializer_list<size_t> ks) const
+    {
+        return multinomial(ks.begin(),ks.end());
+    }
+    template <typename It>
+    M multinomial(It begin, It end) const
+    {
+        size_t s = 0;
+        M ret = 1;
+        for (; begin != end; ++begin)
+        {
+            s += *begin;
+            assert(s < _fact.size()); // sum (so also each k_i) at most N
+            ret *= _inv_fact[*begin];
+        }
+        return ret * _fact[s];
+    }
+};
+
+int main(int argc, char **argv)
+{
+    typedef ModInt<1000000007> M;
+    const factorial_table<M> t(1000);
+    assert(t.size() == 1001);
+    assert(t.fact(0) == 1 && t.fact(10) == 3628800 && t.inv_fact(0) == 1);
+    assert(t.comb(5,2) == 10 && t.comb(2,5) == 0 && t.comb(0,0) == 1);
+    assert(t.perm(5,2) == 20 && t.perm(5,6) == 0 && t.perm(7,0) == 1);
+    assert(t.multinomial({2,1,1}) == 12 && t.multinomial({}) == 1);
+    assert(t.multinomial({3,0,3}) == 20);
+    assert(t.comb(1000,500) == M(159835829)); // python: comb(1000,500) % p
+    for (size_t n = 1; n <= 1000; ++n)
+        assert(t.inv(n) * n == 1 && t.fact(n) * t.inv_fact(n) == 1);
+    // pascal's triangle and permutations modulo a small prime, with the
+    // largest table allowed (N = p-1)
+    typedef ModInt<1009> S;
+    const factorial_table<S> s(1008);
+    std::vector<S> row = {1};
+    for (size_t n = 0; n <= 1008; ++n)
+    {
+        S p = 1;
+        for (size_t k = 0; k <= n+1; ++k)
+        {
+            assert(s.comb(n,k) == (k <= n ? row[k] : 0));
+            assert(s.perm(n,k) == (k <= n ? p : 0));
+            p *= n-k;
+        }
+        std::vector<S> next(n+2,S(1));
+        for (size_t k = 1; k <= n; ++k)
+            next[k] = row[k-1] + row[k];
+        row = next;
+    }
+    std::mt19937_64 rng(23);
+    for (int i = 0; i < 1000; ++i)
+    {
+        std::vector<size_t> ks(rng() % 5 + 1);
+        size_t tot = 0;
+        for (size_t& k : ks)
+            tot += k = rng() % 200;
+        // multinomial as a product of binomials
+        M v = 1;
+        size_t part = 0;
+        for (size_t k : ks)
+            v *= t.comb(part += k,k);
+        assert(t.multinomial(ks.begin(),ks.end()) == v && tot == part);
+    }
+
+    // run with "bench" argument for timing
+    if (argc > 1 && std::string(argv[1]) == "bench")
+    {
+        const size_t N = 10000000, Q = 10000000;
+        auto ms = [](auto s, auto t)
+        { return std::chrono::duration<double,std::milli>(t-s).count(); };
+        auto t0 = std::chrono::steady_clock::now();
+        const factorial_table<M> big(N);
+        auto t1 = std::chrono::steady_clock::now();
+        std::vector<uint32_t> ns(Q), ks(Q);
+        for (size_t i = 0; i < Q; ++i)
+            ns[i] = rng() % (N+1), ks[i] = rng() % (ns[i]+1);
+        auto t2 = std::chrono::steady_clock::now();
+        M sum = 0;
+        for (size_t i = 0; i < Q; ++i)
+            sum += big.comb(ns[i],ks[i]);
+        auto t3 = std::chrono::steady_clock::now();
+        // per query inverse with pow (fermat) for comparison
+        M sum2 = 0;
+        for (size_t i = 0; i < Q/100; ++i)
+            sum2 += big.fact(ns[i])
+                * (big.fact(ks[i]) * big.fact(ns[i]-ks[i])).pow(1000000005);
+        auto t4 = std::chrono::steady_clock::now();
+        M sum3 = 0;
+        for (size_t i = 0; i < Q/100; ++i)
+            sum3 += big.comb(ns[i],ks[i]);
+        assert(sum2 == sum3 && sum != 0);
+        printf("table for N = %zu: build %.1f ms, %zu comb %.1f ms, "
+            "%zu comb with pow inverses %.1f ms\n",N,ms(t0,t1),Q,ms(t2,t3),
+            Q/100,ms(t3,t4));
+    }
+}
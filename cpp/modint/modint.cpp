@@ -0,0 +1,303 @@
+/*
+Modular integer with a compile time modulus in montgomery form
+
+ModInt<P> stores x*R mod P (R = 2^32) for an odd modulus P < 2^31, so
+multiplication is a 64 bit product and a montgomery reduction (2 more
+multiplications and a shift) with no division. The constants (-P^-1 mod 2^32
+and R^2 mod P) are derived at compile time. Addition and subtraction are
+branch free (the wrap around is a mask from the sign bit).
+
+The operators mirror ModInt in py/exact_math/modint.py: arithmetic with other
+ModInt<P> or integers (reduced modulo P, negative allowed), comparisons by the
+value in [0,P), ~ for the inverse, / as multiplication by the inverse and pow
+with negative exponents through the inverse. Inverting a non invertible value
+fails an assertion (like the assertions in modinv).
+*/
+
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <ostream>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+template <uint32_t P>
+class ModInt
+{
+    static_assert(P % 2 == 1 && P < (1u << 31),"P must be odd and below 2^31");
+
+    // -P^-1 mod 2^32 by newton iteration (each step doubles the correct bits)
+    static constexpr uint32_t _neg_inv()
+    {
+        uint32_t inv = P;
+        for (int i = 0; i < 4; ++i)
+            inv *= 2 - P*inv;
+        return -inv;
+    }
+
+    static constexpr uint32_t _NINV = _neg_inv();
+    static constexpr uint32_t _R2 = (uint32_t) (((__uint128_t) 1 << 64) % P);
+    uint32_t _v; // montgomery form, in [0,P)
+
+    // t*R^-1 mod P for t < P*2^32
+    static constexpr uint32_t _reduce(uint64_t t)
+    {
+        const uint32_t m = (uint32_t) t * _NINV;
+        const uint32_t r = (t + (uint64_t) m*P) >> 32; // < 2P
+        return r >= P ? r - P : r;
+    }
+
+    // integer to [0,P) including negative values
+    template <typename I>
+    static constexpr uint32_t _mod(I x)
+    {
+        static_assert(std::is_integral_v<I>);
+        if constexpr (std::is_signed_v<I>)
+        {
+            const int64_t r = (int64_t) x % (int64_t) P;
+            return r < 0 ? r + P : r;
+        }
+        else
+            return (uint64_t) x % P;
+    }
+
+    // value from montgomery form without conversion
+    static constexpr ModInt _raw(uint32_t v)
+    {
+        ModInt ret;
+        ret._v = v;
+        return ret;
+    }
+
+public:
+    constexpr ModInt(): _v(0) {}
+    template <typename I, typename = std::enable_if_t<std::is_integral_v<I>>>
+    constexpr ModInt(I x): _v(_reduce((uint64_t) _mod(x)*_R2)) {}
+
+    static constexpr uint32_t mod() { return P; }
+    // value in [0,P)
+    constexpr uint32_t val() const { return _reduce(_v); }
+    explicit constexpr operator uint32_t() const { return val(); }
+    explicit constexpr operator bool() const { return _v != 0; }
+
+    // arithmetic
+    constexpr ModInt& operator+=(const ModInt& o)
+    {
+        const uint32_t r = _v + o._v - P; // wraps below 0 when _v+o._v < P
+        _v = r + (-(r >> 31) & P);
+        return *this;
+    }
+    constexpr ModInt& operator-=(const ModInt& o)
+    {
+        const uint32_t r = _v - o._v;
+        _v = r + (-(r >> 31) & P);
+        return *this;
+    }
+    constexpr ModInt& operator*=(const ModInt& o)
+    {
+        _v = _reduce((uint64_t) _v*o._v);
+        return *this;
+    }
+    constexpr ModInt& operator/=(const ModInt& o) { return *this *= ~o; }
+
+    friend constexpr ModInt operator+(ModInt a, const ModInt& b)
+    { return a += b; }
+    friend constexpr ModInt operator-(ModInt a, const ModInt& b)
+    { return a -= b; }
+    friend constexpr ModInt operator*(ModInt a, const ModInt& b)
+    { return a *= b; }
+    friend constexpr ModInt operator/(ModInt a, const ModInt& b)
+    { return a /= b; }
+
+    constexpr ModInt operator+() const { return *this; }
+    constexpr ModInt operator-() const { return ModInt() - *this; }
+
+    // inverse with the extended euclidean algorithm (P may be composite)
+    constexpr ModInt operator~() const
+    {
+        assert(P > 1 && _v != 0); // 0 has no inverse
+        int64_t r0 = val(), r1 = P, s0 = 1, s1 = 0;
+        while (r1)
+        {
+            const int64_t q = r0/r1;
+            r0 -= q*r1;
+            s0 -= q*s1;
+            std::swap(r0,r1);
+            std::swap(s0,s1);
+        }
+        assert(r0 == 1); // not invertible
+        return ModInt(s0);
+    }
+
+    // power, negative exponents use the inverse
+    constexpr ModInt pow(int64_t e) const
+    {
+        ModInt b = e < 0 ? ~*this : *this, ret = _raw(_reduce(_R2));
+        uint64_t k = e < 0 ? -(uint64_t) e : e;
+        for (; k; k >>= 1, b *= b)
+            if (k & 1)
+                ret *= b;
+        return P == 1 ? ModInt() : ret;
+    }
+
+    // comparisons by value (montgomery form is a bijection so == is direct)
+    friend constexpr bool operator==(const ModInt& a, const ModInt& b)
+    { return a._v == b._v; }
+    friend constexpr bool operator!=(const ModInt& a, const ModInt& b)
+    { return a._v != b._v; }
+    friend constexpr bool operator<(const ModInt& a, const ModInt& b)
+    { return a.val() < b.val(); }
+    friend constexpr bool operator<=(const ModInt& a, const ModInt& b)
+    { return a.val() <= b.val(); }
+    friend constexpr bool operator>(const ModInt& a, const ModInt& b)
+    { return a.val() > b.val(); }
+    friend constexpr bool operator>=(const ModInt& a, const ModInt& b)
+    { return a.val() >= b.val(); }
+
+    friend std::ostream& operator<<(std::ostream& os, const ModInt& a)
+    { return os << a.val(); }
+};
+
+// compile time use
+static_assert(ModInt<998244353>(3).pow(998244352) == 1);
+static_assert((ModInt<998244353>(2) / 3 * 3).val() == 2);
+static_assert(ModInt<15>(-4).val() == 11);
+
+int main(int argc, char **argv)
+{
+    // tests from py/exact_math/modint.py with odd moduli
+    assert(ModInt<1>(0).val() == 0 && ModInt<7>(0).val() == 0);
+    assert(ModInt<15>(4).val() == 4 && ModInt<15>(-4).val() == 11);
+    assert(ModInt<15>(62).val() == 2 && ModInt<15>::mod() == 15);
+    std::ostringstream ss;
+    ss << ModInt<1>(-1) << ' ' << ModInt<11>(16) << ' ' << ModInt<5>(3);
+    assert(ss.str() == "0 5 3");
+    assert(ModInt<7>(5) == 5 && ModInt<7>(5) == -2 && ModInt<7>(5) == 12);
+    assert(ModInt<1>(0) == 1234 && ModInt<17>(14) == ModInt<17>(-3));
+    assert(ModInt<83>(-20) == ModInt<83>(893) && ModInt<21>(10) != 11);
+    assert(ModInt<7>(6) != 7 && !(ModInt<7>(6) != -1));
+    assert(!(ModInt<11>(5) < 4) && !(ModInt<11>(5) < 5) && ModInt<11>(5) < 6);
+    assert(ModInt<31>(9) <= 9 && !(ModInt<31>(9) <= ModInt<31>(8)));
+    assert(ModInt<11>(5) > 4 && !(ModInt<11>(5) > 5));
+    assert(ModInt<31>(9) >= 9 && !(ModInt<31>(9) >= ModInt<31>(10)));
+    assert(!ModInt<1>(1) && !ModInt<9>(0) && ModInt<9>(3) && ModInt<3>(1));
+    assert(-ModInt<1>(0) == 0 && -ModInt<3>(0) == 0 && -ModInt<3>(1) == 2);
+    assert(-ModInt<29>(-3) == 3 && -ModInt<29>(26) == 3 && +ModInt<3>(2) == 2);
+    assert(~ModInt<3>(1) == 1 && ~ModInt<3>(2) == 2 && ~ModInt<5>(2) == 3);
+    assert(~ModInt<19>(2) == 10 && ~ModInt<17>(4) == 13);
+    assert(~ModInt<25>(7) == 18 && ~ModInt<21>(5) == 17);
+    assert(ModInt<3>(1) + 2 == 0 && ModInt<23>(12) + 14 == 3);
+    assert(ModInt<23>(12) + (-3) == 9 && ModInt<15>(6) + 0 == 6);
+    assert(ModInt<37>(14) - 9 == 5 && ModInt<41>(6) - 7 == 40);
+    assert(ModInt<17>(5) - (-7) == 12 && ModInt<7>(4) * 3 == 5);
+    assert(ModInt<13>(5) * 7 == -4 && ModInt<19>(5) * (-3) == 4);
+    assert(ModInt<13>(4) / 5 == 6 && ModInt<9>(3) / 2 == 6);
+    assert(3 + ModInt<9>(5) == 8 && -6 + ModInt<9>(5) == 8);
+    assert(12 - ModInt<15>(4) == 8 && -3 - ModInt<15>(4) == 8);
+    assert(-2 * ModInt<7>(4) == 6 && 5 / ModInt<5>(2) == 0);
+    assert(3 / ModInt<7>(5) == 2 && -1 / ModInt<9>(2) == 4);
+    assert(ModInt<1>(0).pow(5790) == 0 && ModInt<1>(0).pow(0) == 0);
+    assert(ModInt<15>(1).pow(10) == 1 && ModInt<15>(4).pow(-1) == 4);
+    assert(ModInt<15>(7).pow(-2) == 4 && ModInt<17>(12).pow(-1) == 10);
+    assert(ModInt<17>(12).pow(-2) == -2 && ModInt<17>(12).pow(-16) == 1);
+    assert(ModInt<21>(8).pow(2) == 1 && ModInt<21>(0).pow(0) == 1);
+    ModInt<13> c = 5;
+    c += 10;
+    c *= 3;
+    c -= 8;
+    c /= 4;
+    assert(c == 6);
+    assert(ModInt<13>(-9223372036854775807ll-1) == 5);
+    assert(ModInt<13>(~0ull) == 2);
+
+    // random operations against 64 bit arithmetic
+    auto check = [](auto z)
+    {
+        typedef decltype(z) M;
+        const uint64_t p = M::mod();
+        std::mt19937_64 rng(p);
+        for (int i = 0; i < 100000; ++i)
+        {
+            const uint64_t a = rng() % p, b = rng() % p;
+            const int64_t e = rng() % 1000;
+            const M x = a, y = b;
+            assert((x+y).val() == (a+b) % p);
+            assert((x-y).val() == (a+p-b) % p);
+            assert((x*y).val() == a*b % p);
+            uint64_t q = 1;
+            for (int64_t j = 0; j < e; ++j)
+                q = q*a % p;
+            if (i < 1000)
+                assert(x.pow(e).val() == q);
+            if (std::gcd(b,p) == 1)
+                assert((x/y*y).val() == a);
+            assert(((int64_t) a < (int64_t) b) == (x < y));
+        }
+        assert(M(p-1)+1 == 0 && M(0)-1 == M(p-1) && M(p-1)*M(p-1) == 1);
+    };
+    check(ModInt<998244353>());
+    check(ModInt<1000000007>());
+    check(ModInt<2147483647>());
+    check(ModInt<3>());
+    check(ModInt<999999999>());
+
+    // run with "bench" argument for timing
+    if (argc > 1 && std::string(argv[1]) == "bench")
+    {
+        typedef ModInt<1000000007> M;
+        const uint64_t p = M::mod();
+        volatile uint64_t vp = p;
+        const uint64_t q = vp; // same modulus unknown at compile time
+        const int N = 1 << 12, R = 50000;
+        std::vector<uint64_t> a(N), a2(N), c(N);
+        std::vector<M> b(N), d(N);
+        std::mt19937_64 rng(1);
+        for (int i = 0; i < N; ++i)
+            b[i] = a[i] = a2[i] = rng() % p;
+        auto sec = [](auto s, auto t)
+        { return std::chrono::duration<double>(t-s).count(); };
+        const double ops = (double) R*N;
+        // latency: each product depends on the previous one
+        auto t0 = std::chrono::steady_clock::now();
+        for (int r = 0; r < R; ++r)
+            for (int i = 1; i < N; ++i)
+                a[i] = a[i]*a[i-1] % p;
+        auto t1 = std::chrono::steady_clock::now();
+        for (int r = 0; r < R; ++r)
+            for (int i = 1; i < N; ++i)
+                a2[i] = a2[i]*a2[i-1] % q;
+        auto t2 = std::chrono::steady_clock::now();
+        for (int r = 0; r < R; ++r)
+            for (int i = 1; i < N; ++i)
+                b[i] *= b[i-1];
+        auto t3 = std::chrono::steady_clock::now();
+        for (int i = 0; i < N; ++i)
+            assert(b[i] == a[i] && a[i] == a2[i]);
+        printf("%g dependent mulmod: %% constant %.3f sec, %% runtime %.3f sec, "
+            "montgomery %.3f sec\n",ops,sec(t0,t1),sec(t1,t2),sec(t2,t3));
+        // throughput: independent products along arrays
+        t0 = std::chrono::steady_clock::now();
+        for (int r = 0; r < R; ++r)
+            for (int i = 0; i < N; ++i)
+                c[i] = (c[i] + a[i]*a[(i+r)%N]) % p;
+        t1 = std::chrono::steady_clock::now();
+        for (int r = 0; r < R; ++r)
+            for (int i = 0; i < N; ++i)
+                c[i] = (c[i] + a[i]*a[(i+r)%N]) % q;
+        t2 = std::chrono::steady_clock::now();
+        for (int r = 0; r < R; ++r)
+            for (int i = 0; i < N; ++i)
+                d[i] += b[i]*b[(i+r)%N];
+        t3 = std::chrono::steady_clock::now();
+        for (int i = 0; i < N; ++i)
+            assert(d[i]*2 == c[i]);
+        printf("%g independent multiply add: %% constant %.3f sec, "
+            "%% runtime %.3f sec, montgomery %.3f sec\n",
+            ops,sec(t0,t1),sec(t1,t2),sec(t2,t3));
+    }
+}
@@ -0,0 +1,282 @@
+/*
+Modular integer with a 64 bit compile time modulus
+
+ModInt64<P> for an odd modulus P < 2^63 stores x*R mod P (R = 2^64) and
+multiplies with a 128 bit product and montgomery reduction: with
+q = t*P^-1 mod 2^64, t - q*P is divisible by 2^64 and equals
+hi(t) - hi(q*P) after the shift, so the reduction is 2 more multiplications
+and one conditional add (no 128 bit division).
+
+For the mersenne prime P = 2^61-1 (common for hashing) the value is stored
+directly and a product t = a*b < 2^122 is reduced with 2^61 = 1 (mod P) as
+(t & P) + (t >> 61), then one conditional subtraction.
+
+The operators mirror ModInt in py/exact_math/modint.py, as for ModInt<P>.
+*/
+
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <numeric>
+#include <ostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+typedef unsigned __int128 u128;
+
+template <uint64_t P>
+class ModInt64
+{
+    static_assert(P % 2 == 1 && P < (1ull << 63),"P must be odd and below 2^63");
+
+    static constexpr bool _MERSENNE = P == (1ull << 61) - 1;
+
+    // P^-1 mod 2^64 by newton iteration
+    static constexpr uint64_t _inv()
+    {
+        uint64_t inv = P;
+        for (int i = 0; i < 5; ++i)
+            inv *= 2 - P*inv;
+        return inv;
+    }
+
+    static constexpr uint64_t _PINV = _inv();
+    static constexpr uint64_t _R2 = (uint64_t) ((((u128) 1 << 64) % P)
+        * (((u128) 1 << 64) % P) % P);
+    uint64_t _v; // montgomery form (or plain for mersenne), in [0,P)
+
+    // t*R^-1 mod P for t < P*2^64
+    static constexpr uint64_t _reduce(u128 t)
+    {
+        const uint64_t q = (uint64_t) t * _PINV;
+        const uint64_t h = ((u128) q*P) >> 64, th = t >> 64;
+        return th - h + (th < h ? P : 0);
+    }
+
+    // t mod 2^61-1 for t < 2^122
+    static constexpr uint64_t _reduce_mersenne(u128 t)
+    {
+        const uint64_t r = ((uint64_t) t & P) + (uint64_t) (t >> 61);
+        return r >= P ? r - P : r;
+    }
+
+    static constexpr uint64_t _mulmod(uint64_t a, uint64_t b)
+    {
+        if constexpr (_MERSENNE)
+            return _reduce_mersenne((u128) a*b);
+        else
+            return _reduce((u128) a*b);
+    }
+
+    template <typename I>
+    static constexpr uint64_t _mod(I x)
+    {
+        static_assert(std::is_integral_v<I>);
+        if constexpr (std::is_signed_v<I>)
+        {
+            const int64_t r = (int64_t) x % (int64_t) P;
+            return r < 0 ? r + P : r;
+        }
+        else
+            return (uint64_t) x % P;
+    }
+
+public:
+    constexpr ModInt64(): _v(0) {}
+    template <typename I, typename = std::enable_if_t<std::is_integral_v<I>>>
+    constexpr ModInt64(I x): _v(_MERSENNE ? _mod(x) : _mulmod(_mod(x),_R2)) {}
+
+    static constexpr uint64_t mod() { return P; }
+    // value in [0,P)
+    constexpr uint64_t val() const { return _MERSENNE ? _v : _reduce(_v); }
+    explicit constexpr operator uint64_t() const { return val(); }
+    explicit constexpr operator bool() const { return _v != 0; }
+
+    constexpr ModInt64& operator+=(const ModInt64& o)
+    {
+        const uint64_t r = _v + o._v - P;
+        _v = r + (-(r >> 63) & P);
+        return *this;
+    }
+    constexpr ModInt64& operator-=(const ModInt64& o)
+    {
+        const uint64_t r = _v - o._v;
+        _v = r + (-(r >> 63) & P);
+        return *this;
+    }
+    constexpr ModInt64& operator*=(const ModInt64& o)
+    {
+        _v = _mulmod(_v,o._v);
+        return *this;
+    }
+    constexpr ModInt64& operator/=(const ModInt64& o) { return *this *= ~o; }
+
+    friend constexpr ModInt64 operator+(ModInt64 a, const ModInt64& b)
+    { return a += b; }
+    friend constexpr ModInt64 operator-(ModInt64 a, const ModInt64& b)
+    { return a -= b; }
+    friend constexpr ModInt64 operator*(ModInt64 a, const ModInt64& b)
+    { return a *= b; }
+    friend constexpr ModInt64 operator/(ModInt64 a, const ModInt64& b)
+    { return a /= b; }
+
+    constexpr ModInt64 operator+() const { return *this; }
+    constexpr ModInt64 operator-() const { return ModInt64() - *this; }
+
+    // inverse with the extended euclidean algorithm (P may be composite)
+    constexpr ModInt64 operator~() const
+    {
+        assert(P > 1 && _v != 0); // 0 has no inverse
+        int64_t r0 = val(), r1 = P, s0 = 1, s1 = 0;
+        while (r1)
+        {
+            const int64_t q = r0/r1;
+            r0 -= q*r1;
+            s0 -= q*s1;
+            std::swap(r0,r1);
+            std::swap(s0,s1);
+        }
+        assert(r0 == 1); // not invertible
+        return ModInt64(s0);
+    }
+
+    // power, negative exponents use the inverse
+    constexpr ModInt64 pow(int64_t e) const
+    {
+        ModInt64 b = e < 0 ? ~*this : *this, ret = 1;
+        for (uint64_t k = e < 0 ? -(uint64_t) e : e; k; k >>= 1, b *= b)
+            if (k & 1)
+                ret *= b;
+        return ret;
+    }
+
+    friend constexpr bool operator==(const ModInt64& a, const ModInt64& b)
+    { return a._v == b._v; }
+    friend constexpr bool operator!=(const ModInt64& a, const ModInt64& b)
+    { return a._v != b._v; }
+    friend constexpr bool operator<(const ModInt64& a, const ModInt64& b)
+    { return a.val() < b.val(); }
+    friend constexpr bool operator<=(const ModInt64& a, const ModInt64& b)
+    { return a.val() <= b.val(); }
+    friend constexpr bool operator>(const ModInt64& a, const ModInt64& b)
+    { return a.val() > b.val(); }
+    friend constexpr bool operator>=(const ModInt64& a, const ModInt64& b)
+    { return a.val() >= b.val(); }
+
+    friend std::ostream& operator<<(std::ostream& os, const ModInt64& a)
+    { return os << a.val(); }
+};
+
+// compile time use
+static_assert(ModInt64<1000000000000000003ull>(2).pow(1000000000000000002ll)
+    == 1);
+static_assert(ModInt64<(1ull << 61) - 1>(3).pow((1ll << 61) - 2) == 1);
+static_assert((ModInt64<(1ull << 61) - 1>(5) / 7 * 7).val() == 5);
+
+int main(int argc, char **argv)
+{
+    // tests from py/exact_math/modint.py with odd moduli
+    assert(ModInt64<1>(5).val() == 0 && ModInt64<15>(-4).val() == 11);
+    assert(ModInt64<15>(62).val() == 2 && ModInt64<15>::mod() == 15);
+    std::ostringstream ss;
+    ss << ModInt64<1>(-1) << ' ' << ModInt64<11>(16) << ' '
+        << ModInt64<(1ull << 61) - 1>(-1);
+    assert(ss.str() == "0 5 2305843009213693950");
+    assert(ModInt64<7>(5) == -2 && ModInt64<83>(-20) == ModInt64<83>(893));
+    assert(ModInt64<11>(5) < 6 && !(ModInt64<11>(5) < 5));
+    assert(ModInt64<31>(9) >= 9 && ModInt64<31>(9) > 8);
+    assert(!ModInt64<9>(0) && ModInt64<9>(3) && -ModInt64<29>(26) == 3);
+    assert(~ModInt64<19>(2) == 10 && ~ModInt64<25>(7) == 18);
+    assert(ModInt64<23>(12) + 14 == 3 && ModInt64<41>(6) - 7 == 40);
+    assert(ModInt64<13>(5) * 7 == -4 && ModInt64<13>(4) / 5 == 6);
+    assert(-1 / ModInt64<9>(2) == 4 && 12 - ModInt64<15>(4) == 8);
+    assert(ModInt64<15>(7).pow(-2) == 4 && ModInt64<17>(12).pow(-16) == 1);
+    assert(ModInt64<1>(0).pow(0) == 0);
+
+    // random operations against 128 bit arithmetic
+    auto check = [](auto z)
+    {
+        typedef decltype(z) M;
+        const uint64_t p = M::mod();
+        std::mt19937_64 rng(p);
+        for (int i = 0; i < 100000; ++i)
+        {
+            const uint64_t a = rng() % p, b = rng() % p, c = rng();
+            const int64_t s = rng();
+            const M x = a, y = b;
+            assert(M(c).val() == c % p);
+            const int64_t sr = s % (int64_t) p;
+            assert(M(s).val() == (uint64_t) (sr < 0 ? sr + p : sr));
+            assert((x+y).val() == (uint64_t) (((u128) a+b) % p));
+            assert((x-y).val() == (uint64_t) (((u128) a+p-b) % p));
+            assert((x*y).val() == (uint64_t) ((u128) a*b % p));
+            if (i < 1000)
+            {
+                const int64_t e = rng() % 200;
+                u128 q = 1 % p;
+                for (int64_t j = 0; j < e; ++j)
+                    q = q*a % p;
+                assert(x.pow(e).val() == q);
+            }
+            if (std::gcd(b,p) == 1)
+                assert((x/y*y).val() == a);
+        }
+        assert(M(p-1)+1 == 0 && M(0)-1 == M(p-1) && M(p-1)*M(p-1) == 1);
+    };
+    check(ModInt64<(1ull << 61) - 1>());
+    check(ModInt64<1000000000000000003ull>());
+    check(ModInt64<9223372036854775783ull>());
+    check(ModInt64<(1ull << 63) - 1>());
+    check(ModInt64<1000000007>());
+    check(ModInt64<3>());
+
+    // run with "bench" argument for timing
+    if (argc > 1 && std::string(argv[1]) == "bench")
+    {
+        const int N = 1 << 12, R = 20000;
+        auto sec = [](auto s, auto t)
+        { return std::chrono::duration<double>(t-s).count(); };
+        auto bench = [&](auto z, const char *name)
+        {
+            typedef decltype(z) M;
+            const uint64_t p = M::mod();
+            std::vector<uint64_t> a(N), c(N);
+            std::vector<M> b(N), d(N);
+            std::mt19937_64 rng(1);
+            for (int i = 0; i < N; ++i)
+                b[i] = a[i] = rng() % p;
+            auto t0 = std::chrono::steady_clock::now();
+            for (int r = 0; r < R; ++r)
+                for (int i = 1; i < N; ++i)
+                    a[i] = (u128) a[i]*a[i-1] % p;
+            auto t1 = std::chrono::steady_clock::now();
+            for (int r = 0; r < R; ++r)
+                for (int i = 1; i < N; ++i)
+                    b[i] *= b[i-1];
+            auto t2 = std::chrono::steady_clock::now();
+            for (int r = 0; r < R; ++r)
+                for (int i = 0; i < N; ++i)
+                    c[i] = (c[i] + (u128) a[i]*a[(i+r)%N]) % p;
+            auto t3 = std::chrono::steady_clock::now();
+            for (int r = 0; r < R; ++r)
+                for (int i = 0; i < N; ++i)
+                    d[i] += b[i]*b[(i+r)%N];
+            auto t4 = std::chrono::steady_clock::now();
+            for (int i = 0; i < N; ++i)
+                assert(b[i] == a[i] && d[i] == c[i]);
+            const double mops = (double) R*N/1e6;
+            printf("%s: dependent mulmod %.1f M/s (__int128 %%: %.1f M/s), "
+                "multiply add %.1f M/s (__int128 %%: %.1f M/s)\n",name,
+                mops/sec(t1,t2),mops/sec(t0,t1),mops/sec(t3,t4),
+                mops/sec(t2,t3));
+        };
+        bench(ModInt64<(1ull << 61) - 1>(),"2^61-1 (mersenne)");
+        bench(ModInt64<(1ull << 61) + 15>(),"2^61+15 (montgomery)");
+        bench(ModInt64<1000000000000000003ull>(),"10^18+3 (montgomery)");
+    }
+}
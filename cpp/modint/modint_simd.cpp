@@ -0,0 +1,533 @@
+/*
+Vectorized array kernels for ModInt<P>
+
+Elementwise add, sub, mul, multiplication by a scalar and the dot product over
+arrays of ModInt<P> (the montgomery form class of modint.cpp, copied here),
+processing 16 lanes with AVX-512 or 8 lanes with AVX2, chosen at runtime from
+the cpu features, with a scalar fallback.
+
+The vector montgomery product uses _mul_epu32 (32x32 -> 64 bit) separately on
+the even and odd lanes. With t = a*b and q = t*P^-1 mod 2^32, the low halves of
+t and q*P are equal, so the result is hi(t) - hi(q*P) in (-P,P) and min_epu32
+of r and r+P picks the representative in [0,P) (negative r is a large unsigned
+value). Sums use the same min trick. AVX-512 uses masked add/sub for these
+corrections instead. The lanes produce the same montgomery values as the
+scalar operators, so the kernels can be mixed with scalar code.
+*/
+
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <ostream>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <immintrin.h>
+
+template <uint32_t P>
+class ModInt
+{
+    static_assert(P % 2 == 1 && P < (1u << 31),"P must be odd and below 2^31");
+
+    // -P^-1 mod 2^32 by newton iteration (each step doubles the correct bits)
+    static constexpr uint32_t _neg_inv()
+    {
+        uint32_t inv = P;
+        for (int i = 0; i < 4; ++i)
+            inv *= 2 - P*inv;
+        return -inv;
+    }
+
+    static constexpr uint32_t _NINV = _neg_inv();
+    static constexpr uint32_t _R2 = (uint32_t) (((__uint128_t) 1 << 64) % P);
+    uint32_t _v; // montgomery form, in [0,P)
+
+    // t*R^-1 mod P for t < P*2^32
+    static constexpr uint32_t _reduce(uint64_t t)
+    {
+        const uint32_t m = (uint32_t) t * _NINV;
+        const uint32_t r = (t + (uint64_t) m*P) >> 32; // < 2P
+        return r >= P ? r - P : r;
+    }
+
+    // integer to [0,P) including negative values
+    template <typename I>
+    static constexpr uint32_t _mod(I x)
+    {
+        static_assert(std::is_integral_v<I>);
+        if constexpr (std::is_signed_v<I>)
+        {
+            const int64_t r = (int64_t) x % (int64_t) P;
+            return r < 0 ? r + P : r;
+        }
+        else
+            return (uint64_t) x % P;
+    }
+
+    // value from montgomery form without conversion
+    static constexpr ModInt _raw(uint32_t v)
+    {
+        ModInt ret;
+        ret._v = v;
+        return ret;
+    }
+
+public:
+    constexpr ModInt(): _v(0) {}
+    template <typename I, typename = std::enable_if_t<std::is_integral_v<I>>>
+    constexpr ModInt(I x): _v(_reduce((uint64_t) _mod(x)*_R2)) {}
+
+    static constexpr uint32_t mod() { return P; }
+    // value in [0,P)
+    constexpr uint32_t val() const { return _reduce(_v); }
+    explicit constexpr operator uint32_t() const { return val(); }
+    explicit constexpr operator bool() const { return _v != 0; }
+
+    // arithmetic
+    constexpr ModInt& operator+=(const ModInt& o)
+    {
+        const uint32_t r = _v + o._v - P; // wraps below 0 when _v+o._v < P
+        _v = r + (-(r >> 31) & P);
+        return *this;
+    }
+    constexpr ModInt& operator-=(const ModInt& o)
+    {
+        const uint32_t r = _v - o._v;
+        _v = r + (-(r >> 31) & P);
+        return *this;
+    }
+    constexpr ModInt& operator*=(const ModInt& o)
+    {
+        _v = _reduce((uint64_t) _v*o._v);
+        return *this;
+    }
+    constexpr ModInt& operator/=(const ModInt& o) { return *this *= ~o; }
+
+    friend constexpr ModInt operator+(ModInt a, const ModInt& b)
+    { return a += b; }
+    friend constexpr ModInt operator-(ModInt a, const ModInt& b)
+    { return a -= b; }
+    friend constexpr ModInt operator*(ModInt a, const ModInt& b)
+    { return a *= b; }
+    friend constexpr ModInt operator/(ModInt a, const ModInt& b)
+    { return a /= b; }
+
+    constexpr ModInt operator+() const { return *this; }
+    constexpr ModInt operator-() const { return ModInt() - *this; }
+
+    // inverse with the extended euclidean algorithm (P may be composite)
+    constexpr ModInt operator~() const
+    {
+        assert(P > 1 && _v != 0); // 0 has no inverse
+        int64_t r0 = val(), r1 = P, s0 = 1, s1 = 0;
+        while (r1)
+        {
+            const int64_t q = r0/r1;
+            r0 -= q*r1;
+            s0 -= q*s1;
+            std::swap(r0,r1);
+            std::swap(s0,s1);
+        }
+        assert(r0 == 1); // not invertible
+        return ModInt(s0);
+    }
+
+    // power, negative exponents use the inverse
+    constexpr ModInt pow(int64_t e) const
+    {
+        ModInt b = e < 0 ? ~*this : *this, ret = _raw(_reduce(_R2));
+        uint64_t k = e < 0 ? -(uint64_t) e : e;
+        for (; k; k >>= 1, b *= b)
+            if (k & 1)
+                ret *= b;
+        return P == 1 ? ModInt() : ret;
+    }
+
+    // comparisons by value (montgomery form is a bijection so == is direct)
+    friend constexpr bool operator==(const ModInt& a, const ModInt& b)
+    { return a._v == b._v; }
+    friend constexpr bool operator!=(const ModInt& a, const ModInt& b)
+    { return a._v != b._v; }
+    friend constexpr bool operator<(const ModInt& a, const ModInt& b)
+    { return a.val() < b.val(); }
+    friend constexpr bool operator<=(const ModInt& a, const ModInt& b)
+    { return a.val() <= b.val(); }
+    friend constexpr bool operator>(const ModInt& a, const ModInt& b)
+    { return a.val() > b.val(); }
+    friend constexpr bool operator>=(const ModInt& a, const ModInt& b)
+    { return a.val() >= b.val(); }
+
+    friend std::ostream& operator<<(std::ostream& os, const ModInt& a)
+    { return os << a.val(); }
+};
+
+// P^-1 mod 2^32
+template <uint32_t P>
+static constexpr uint32_t _inv32()
+{
+    uint32_t inv = P;
+    for (int i = 0; i < 4; ++i)
+        inv *= 2 - P*inv;
+    return inv;
+}
+
+enum _modint_op { _OP_ADD, _OP_SUB, _OP_MUL };
+
+// kernels on montgomery values (ModInt<P> arrays viewed as uint32_t), b is
+// broadcast from b[0] when scalar is true
+
+template <uint32_t P, _modint_op OP>
+static void _kernel_scalar(const uint32_t *a, const uint32_t *b, uint32_t *out,
+    size_t n, bool scalar)
+{
+    const ModInt<P> *x = (const ModInt<P>*) a, *y = (const ModInt<P>*) b;
+    ModInt<P> *z = (ModInt<P>*) out;
+    for (size_t i = 0; i < n; ++i)
+    {
+        const ModInt<P> u = x[i], v = scalar ? y[0] : y[i];
+        if constexpr (OP == _OP_ADD)
+            z[i] = u + v;
+        else if constexpr (OP == _OP_SUB)
+            z[i] = u - v;
+        else
+            z[i] = u * v;
+    }
+}
+
+template <uint32_t P>
+static ModInt<P> _dot_scalar(const ModInt<P> *a, const ModInt<P> *b, size_t n)
+{
+    ModInt<P> ret;
+    for (size_t i = 0; i < n; ++i)
+        ret += a[i]*b[i];
+    return ret;
+}
+
+__attribute__((target("avx2")))
+static inline __m256i _mont_mul_avx2(__m256i a, __m256i b, __m256i p,
+    __m256i pinv)
+{
+    const __m256i te = _mm256_mul_epu32(a,b);
+    const __m256i to = _mm256_mul_epu32(_mm256_srli_epi64(a,32),
+        _mm256_srli_epi64(b,32));
+    const __m256i ue = _mm256_mul_epu32(_mm256_mul_epu32(te,pinv),p);
+    const __m256i uo = _mm256_mul_epu32(_mm256_mul_epu32(to,pinv),p);
+    // hi(t) - hi(q*P) in the high half of each 64 bit lane
+    const __m256i re = _mm256_srli_epi64(_mm256_sub_epi64(te,ue),32);
+    const __m256i ro = _mm256_sub_epi64(to,uo);
+    const __m256i r = _mm256_blend_epi32(re,ro,0xaa);
+    return _mm256_min_epu32(r,_mm256_add_epi32(r,p));
+}
+
+template <uint32_t P, _modint_op OP>
+__attribute__((target("avx2")))
+static inline __m256i _op_avx2(__m256i x, __m256i y)
+{
+    const __m256i p = _mm256_set1_epi32(P);
+    if constexpr (OP == _OP_ADD)
+    {
+        const __m256i s = _mm256_add_epi32(x,y);
+        return _mm256_min_epu32(s,_mm256_sub_epi32(s,p));
+    }
+    else if constexpr (OP == _OP_SUB)
+    {
+        const __m256i d = _mm256_sub_epi32(x,y);
+        return _mm256_min_epu32(d,_mm256_add_epi32(d,p));
+    }
+    else
+        return _mont_mul_avx2(x,y,p,_mm256_set1_epi32(_inv32<P>()));
+}
+
+template <uint32_t P, _modint_op OP>
+__attribute__((target("avx2")))
+static void _kernel_avx2(const uint32_t *a, const uint32_t *b, uint32_t *out,
+    size_t n, bool scalar)
+{
+    const __m256i bs = _mm256_set1_epi32(scalar ? b[0] : 0);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        const __m256i x = _mm256_loadu_si256((const __m256i*) (a+i));
+        const __m256i y = scalar ? bs
+            : _mm256_loadu_si256((const __m256i*) (b+i));
+        _mm256_storeu_si256((__m256i*) (out+i),_op_avx2<P,OP>(x,y));
+    }
+    _kernel_scalar<P,OP>(a+i,scalar ? b : b+i,out+i,n-i,scalar);
+}
+
+template <uint32_t P>
+__attribute__((target("avx2")))
+static ModInt<P> _dot_avx2(const ModInt<P> *a, const ModInt<P> *b, size_t n)
+{
+    const uint32_t *x = (const uint32_t*) a, *y = (const uint32_t*) b;
+    __m256i acc0 = _mm256_setzero_si256(), acc1 = acc0;
+    size_t i = 0;
+    // 2 accumulators to overlap the latency of the products
+    for (; i + 16 <= n; i += 16)
+    {
+        const __m256i x0 = _mm256_loadu_si256((const __m256i*) (x+i));
+        const __m256i y0 = _mm256_loadu_si256((const __m256i*) (y+i));
+        const __m256i x1 = _mm256_loadu_si256((const __m256i*) (x+i+8));
+        const __m256i y1 = _mm256_loadu_si256((const __m256i*) (y+i+8));
+        acc0 = _op_avx2<P,_OP_ADD>(acc0,_op_avx2<P,_OP_MUL>(x0,y0));
+        acc1 = _op_avx2<P,_OP_ADD>(acc1,_op_avx2<P,_OP_MUL>(x1,y1));
+    }
+    ModInt<P> lanes[8];
+    _mm256_storeu_si256((__m256i*) lanes,_op_avx2<P,_OP_ADD>(acc0,acc1));
+    ModInt<P> ret = _dot_scalar(a+i,b+i,n-i);
+    for (int j = 0; j < 8; ++j)
+        ret += lanes[j];
+    return ret;
+}
+
+// zero masked forms of mul_epu32 and srli_epi64 (same instructions, but the
+// unmasked ones give false uninitialized warnings with the gcc 12 headers)
+__attribute__((target("avx512f")))
+static inline __m512i _mul512(__m512i a, __m512i b)
+{
+    return _mm512_maskz_mul_epu32(0xff,a,b);
+}
+
+__attribute__((target("avx512f")))
+static inline __m512i _hi512(__m512i a)
+{
+    return _mm512_maskz_srli_epi64(0xff,a,32);
+}
+
+template <uint32_t P, _modint_op OP>
+__attribute__((target("avx512f")))
+static inline __m512i _op_avx512(__m512i x, __m512i y)
+{
+    const __m512i p = _mm512_set1_epi32(P);
+    if constexpr (OP == _OP_ADD)
+    {
+        const __m512i s = _mm512_add_epi32(x,y);
+        return _mm512_mask_sub_epi32(s,_mm512_cmpge_epu32_mask(s,p),s,p);
+    }
+    else if constexpr (OP == _OP_SUB)
+    {
+        const __m512i d = _mm512_sub_epi32(x,y);
+        return _mm512_mask_add_epi32(d,_mm512_cmplt_epu32_mask(x,y),d,p);
+    }
+    else
+    {
+        const __m512i pinv = _mm512_set1_epi32(_inv32<P>());
+        const __m512i te = _mul512(x,y), to = _mul512(_hi512(x),_hi512(y));
+        const __m512i ue = _mul512(_mul512(te,pinv),p);
+        const __m512i uo = _mul512(_mul512(to,pinv),p);
+        const __m512i re = _hi512(_mm512_sub_epi64(te,ue));
+        const __m512i ro = _mm512_sub_epi64(to,uo);
+        const __m512i r = _mm512_mask_blend_epi32(0xaaaa,re,ro);
+        return _mm512_mask_add_epi32(r,_mm512_cmplt_epi32_mask(r,
+            _mm512_setzero_si512()),r,p);
+    }
+}
+
+template <uint32_t P, _modint_op OP>
+__attribute__((target("avx512f")))
+static void _kernel_avx512(const uint32_t *a, const uint32_t *b, uint32_t *out,
+    size_t n, bool scalar)
+{
+    const __m512i bs = _mm512_set1_epi32(scalar ? b[0] : 0);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        const __m512i x = _mm512_loadu_si512(a+i);
+        const __m512i y = scalar ? bs : _mm512_loadu_si512(b+i);
+        _mm512_storeu_si512(out+i,_op_avx512<P,OP>(x,y));
+    }
+    _kernel_scalar<P,OP>(a+i,scalar ? b : b+i,out+i,n-i,scalar);
+}
+
+template <uint32_t P>
+__attribute__((target("avx512f")))
+static ModInt<P> _dot_avx512(const ModInt<P> *a, const ModInt<P> *b, size_t n)
+{
+    const uint32_t *x = (const uint32_t*) a, *y = (const uint32_t*) b;
+    __m512i acc0 = _mm512_setzero_si512(), acc1 = acc0;
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32)
+    {
+        const __m512i p0 = _op_avx512<P,_OP_MUL>(_mm512_loadu_si512(x+i),
+            _mm512_loadu_si512(y+i));
+        const __m512i p1 = _op_avx512<P,_OP_MUL>(_mm512_loadu_si512(x+i+16),
+            _mm512_loadu_si512(y+i+16));
+        acc0 = _op_avx512<P,_OP_ADD>(acc0,p0);
+        acc1 = _op_avx512<P,_OP_ADD>(acc1,p1);
+    }
+    ModInt<P> lanes[16];
+    _mm512_storeu_si512(lanes,_op_avx512<P,_OP_ADD>(acc0,acc1));
+    ModInt<P> ret = _dot_scalar(a+i,b+i,n-i);
+    for (int j = 0; j < 16; ++j)
+        ret += lanes[j];
+    return ret;
+}
+
+// 2 = AVX-512, 1 = AVX2, 0 = scalar, detected once (lowered for benchmarks)
+static int _modint_simd_level = __builtin_cpu_supports("avx512f") ? 2
+    : (__builtin_cpu_supports("avx2") ? 1 : 0);
+
+template <uint32_t P, _modint_op OP>
+static void _dispatch(const ModInt<P> *a, const ModInt<P> *b, ModInt<P> *out,
+    size_t n, bool scalar)
+{
+    static_assert(sizeof(ModInt<P>) == sizeof(uint32_t));
+    const uint32_t *x = (const uint32_t*) a, *y = (const uint32_t*) b;
+    uint32_t *z = (uint32_t*) out;
+    if (_modint_simd_level == 2)
+        _kernel_avx512<P,OP>(x,y,z,n,scalar);
+    else if (_modint_simd_level == 1)
+        _kernel_avx2<P,OP>(x,y,z,n,scalar);
+    else
+        _kernel_scalar<P,OP>(x,y,z,n,scalar);
+}
+
+// out[i] = a[i] + b[i] (out may be a or b)
+template <uint32_t P>
+void modint_add(const ModInt<P> *a, const ModInt<P> *b, ModInt<P> *out,
+    size_t n)
+{
+    _dispatch<P,_OP_ADD>(a,b,out,n,false);
+}
+
+// out[i] = a[i] - b[i] (out may be a or b)
+template <uint32_t P>
+void modint_sub(const ModInt<P> *a, const ModInt<P> *b, ModInt<P> *out,
+    size_t n)
+{
+    _dispatch<P,_OP_SUB>(a,b,out,n,false);
+}
+
+// out[i] = a[i] * b[i] (out may be a or b)
+template <uint32_t P>
+void modint_mul(const ModInt<P> *a, const ModInt<P> *b, ModInt<P> *out,
+    size_t n)
+{
+    _dispatch<P,_OP_MUL>(a,b,out,n,false);
+}
+
+// out[i] = a[i] * s (out may be a)
+template <uint32_t P>
+void modint_scalar_mul(const ModInt<P> *a, ModInt<P> s, ModInt<P> *out,
+    size_t n)
+{
+    _dispatch<P,_OP_MUL>(a,&s,out,n,true);
+}
+
+// sum of a[i] * b[i]
+template <uint32_t P>
+ModInt<P> modint_dot(const ModInt<P> *a, const ModInt<P> *b, size_t n)
+{
+    if (_modint_simd_level == 2)
+        return _dot_avx512(a,b,n);
+    if (_modint_simd_level == 1)
+        return _dot_avx2(a,b,n);
+    return _dot_scalar(a,b,n);
+}
+
+template <uint32_t P>
+static void _test()
+{
+    std::mt19937_64 rng(P);
+    const int top = _modint_simd_level;
+    for (size_t n : {0,1,7,8,15,16,17,31,32,33,100,1000})
+    {
+        std::vector<uint64_t> a(n), b(n);
+        std::vector<ModInt<P>> x(n), y(n);
+        for (size_t i = 0; i < n; ++i)
+        {
+            // include the extremes 0 and P-1
+            a[i] = i % 5 == 0 ? P-1 : (i % 7 == 0 ? 0 : rng() % P);
+            b[i] = i % 3 == 0 ? P-1 : rng() % P;
+            x[i] = a[i];
+            y[i] = b[i];
+        }
+        const uint64_t s = rng() % P;
+        for (int level = 0; level <= top; ++level)
+        {
+            _modint_simd_level = level;
+            std::vector<ModInt<P>> z1(n), z2(n), z3(n), z4(n);
+            modint_add(x.data(),y.data(),z1.data(),n);
+            modint_sub(x.data(),y.data(),z2.data(),n);
+            modint_mul(x.data(),y.data(),z3.data(),n);
+            modint_scalar_mul(x.data(),ModInt<P>(s),z4.data(),n);
+            uint64_t dot = 0;
+            for (size_t i = 0; i < n; ++i)
+            {
+                assert(z1[i].val() == (a[i]+b[i]) % P);
+                assert(z2[i].val() == (a[i]+P-b[i]) % P);
+                assert(z3[i].val() == a[i]*b[i] % P);
+                assert(z4[i].val() == a[i]*s % P);
+                dot = (dot + a[i]*b[i]) % P;
+            }
+            assert(modint_dot(x.data(),y.data(),n).val() == dot);
+            // in place
+            std::vector<ModInt<P>> w = x;
+            modint_mul(w.data(),y.data(),w.data(),n);
+            assert(w == z3);
+        }
+    }
+    _modint_simd_level = top;
+}
+
+int main(int argc, char **argv)
+{
+    _test<998244353>();
+    _test<1000000007>();
+    _test<2147483647>();
+    _test<3>();
+    _test<1>();
+
+    // run with "bench" argument for timing
+    if (argc > 1 && std::string(argv[1]) == "bench")
+    {
+        typedef ModInt<998244353> M;
+        const size_t N = 1 << 14;
+        const int R = 20000;
+        std::vector<M> a(N), b(N), c(N);
+        std::mt19937_64 rng(1);
+        for (size_t i = 0; i < N; ++i)
+            a[i] = rng(), b[i] = rng();
+        auto sec = [](auto s, auto t)
+        { return std::chrono::duration<double>(t-s).count(); };
+        const int top = _modint_simd_level;
+        const char *names[] = {"scalar","avx2","avx512"};
+        printf("%zu elements x %d rounds, M elements/sec\n",N,R);
+        for (int level = 0; level <= top; ++level)
+        {
+            _modint_simd_level = level;
+            double t[5];
+            M chk = 0;
+            auto t0 = std::chrono::steady_clock::now();
+            for (int r = 0; r < R; ++r)
+                modint_add(a.data(),b.data(),c.data(),N);
+            auto t1 = std::chrono::steady_clock::now();
+            t[0] = sec(t0,t1);
+            for (int r = 0; r < R; ++r)
+                modint_sub(a.data(),b.data(),c.data(),N);
+            auto t2 = std::chrono::steady_clock::now();
+            t[1] = sec(t1,t2);
+            for (int r = 0; r < R; ++r)
+                modint_mul(a.data(),b.data(),c.data(),N);
+            auto t3 = std::chrono::steady_clock::now();
+            t[2] = sec(t2,t3);
+            for (int r = 0; r < R; ++r)
+                modint_scalar_mul(c.data(),b[r % N],c.data(),N);
+            auto t4 = std::chrono::steady_clock::now();
+            t[3] = sec(t3,t4);
+            for (int r = 0; r < R; ++r)
+                chk += modint_dot(a.data(),c.data(),N);
+            auto t5 = std::chrono::steady_clock::now();
+            t[4] = sec(t4,t5);
+            const double me = (double) N*R/1e6;
+            printf("%-6s add %7.0f  sub %7.0f  mul %7.0f  scalar mul %7.0f  "
+                "dot %7.0f  (check %u)\n",names[level],me/t[0],me/t[1],
+                me/t[2],me/t[3],me/t[4],chk.val());
+        }
+        _modint_simd_level = top;
+    }
+}
@@ -0,0 +1,998 @@
+/*
+Convolution modulo an arbitrary modulus (such as 10^9+7)
+
+For m < 2^31 that is not NTT friendly, the exact product coefficients
+c[k] = sum a[i]*b[k-i] < min(|a|,|b|)*(m-1)^2 are computed modulo the three
+NTT primes 167772161, 469762049 and 754974721 (product about 5.9*10^25) with
+the NTT engine copied from cpp/poly/ntt.cpp, then reconstructed with Garner's
+algorithm (mixed radix CRT): c = x1 + x2*p1 + x3*p1*p2 with
+  x1 = c mod p1
+  x2 = (c - x1)/p1 mod p2
+  x3 = (c - x1 - x2*p1)/(p1*p2) mod p3
+using inverses from bezout/modinv as in py/exact_math/integer.py. Only c mod m
+is needed, so the final sum is done modulo m. The result length is limited to
+2^24 by the transforms modulo 754974721 = 45*2^24+1, and then the exact value
+is below the prime product for every m < 2^31 (min(|a|,|b|) <= 2^23).
+
+convolution_mod_fft does the same with a floating point FFT for comparison.
+Values are split as h*2^15 + l (so m <= 2^30) and the products h*h, h*l+l*h
+and l*l come from 2 forward and 2 inverse complex transforms of length n by
+packing two real sequences into one complex sequence. The rounding is exact
+as long as the error stays below 1/2, which holds up to lengths around 2^20
+(the coefficients reach n*2^30).
+*/
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <ostream>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <immintrin.h>
+
+typedef unsigned __int128 u128;
+
+template <uint32_t P>
+class ModInt
+{
+    static_assert(P % 2 == 1 && P < (1u << 31),"P must be odd and below 2^31");
+
+    // -P^-1 mod 2^32 by newton iteration (each step doubles the correct bits)
+    static constexpr uint32_t _neg_inv()
+    {
+        uint32_t inv = P;
+        for (int i = 0; i < 4; ++i)
+            inv *= 2 - P*inv;
+        return -inv;
+    }
+
+    static constexpr uint32_t _NINV = _neg_inv();
+    static constexpr uint32_t _R2 = (uint32_t) (((__uint128_t) 1 << 64) % P);
+    uint32_t _v; // montgomery form, in [0,P)
+
+    // t*R^-1 mod P for t < P*2^32
+    static constexpr uint32_t _reduce(uint64_t t)
+    {
+        const uint32_t m = (uint32_t) t * _NINV;
+        const uint32_t r = (t + (uint64_t) m*P) >> 32; // < 2P
+        return r >= P ? r - P : r;
+    }
+
+    // integer to [0,P) including negative values
+    template <typename I>
+    static constexpr uint32_t _mod(I x)
+    {
+        static_assert(std::is_integral_v<I>);
+        if constexpr (std::is_signed_v<I>)
+        {
+            const int64_t r = (int64_t) x % (int64_t) P;
+            return r < 0 ? r + P : r;
+        }
+        else
+            return (uint64_t) x % P;
+    }
+
+    // value from montgomery form without conversion
+    static constexpr ModInt _raw(uint32_t v)
+    {
+        ModInt ret;
+        ret._v = v;
+        return ret;
+    }
+
+public:
+    constexpr ModInt(): _v(0) {}
+    template <typename I, typename = std::enable_if_t<std::is_integral_v<I>>>
+    constexpr ModInt(I x): _v(_reduce((uint64_t) _mod(x)*_R2)) {}
+
+    static constexpr uint32_t mod() { return P; }
+    // value in [0,P)
+    constexpr uint32_t val() const { return _reduce(_v); }
+    explicit constexpr operator uint32_t() const { return val(); }
+    explicit constexpr operator bool() const { return _v != 0; }
+
+    // arithmetic
+    constexpr ModInt& operator+=(const ModInt& o)
+    {
+        const uint32_t r = _v + o._v - P; // wraps below 0 when _v+o._v < P
+        _v = r + (-(r >> 31) & P);
+        return *this;
+    }
+    constexpr ModInt& operator-=(const ModInt& o)
+    {
+        const uint32_t r = _v - o._v;
+        _v = r + (-(r >> 31) & P);
+        return *this;
+    }
+    constexpr ModInt& operator*=(const ModInt& o)
+    {
+        _v = _reduce((uint64_t) _v*o._v);
+        return *this;
+    }
+    constexpr ModInt& operator/=(const ModInt& o) { return *this *= ~o; }
+
+    friend constexpr ModInt operator+(ModInt a, const ModInt& b)
+    { return a += b; }
+    friend constexpr ModInt operator-(ModInt a, const ModInt& b)
+    { return a -= b; }
+    friend constexpr ModInt operator*(ModInt a, const ModInt& b)
+    { return a *= b; }
+    friend constexpr ModInt operator/(ModInt a, const ModInt& b)
+    { return a /= b; }
+
+    constexpr ModInt operator+() const { return *this; }
+    constexpr ModInt operator-() const { return ModInt() - *this; }
+
+    // inverse with the extended euclidean algorithm (P may be composite)
+    constexpr ModInt operator~() const
+    {
+        assert(P > 1 && _v != 0); // 0 has no inverse
+        int64_t r0 = val(), r1 = P, s0 = 1, s1 = 0;
+        while (r1)
+        {
+            const int64_t q = r0/r1;
+            r0 -= q*r1;
+            s0 -= q*s1;
+            std::swap(r0,r1);
+            std::swap(s0,s1);
+        }
+        assert(r0 == 1); // not invertible
+        return ModInt(s0);
+    }
+
+    // power, negative exponents use the inverse
+    constexpr ModInt pow(int64_t e) const
+    {
+        ModInt b = e < 0 ? ~*this : *this, ret = _raw(_reduce(_R2));
+        uint64_t k = e < 0 ? -(uint64_t) e : e;
+        for (; k; k >>= 1, b *= b)
+            if (k & 1)
+                ret *= b;
+        return P == 1 ? ModInt() : ret;
+    }
+
+    // comparisons by value (montgomery form is a bijection so == is direct)
+    friend constexpr bool operator==(const ModInt& a, const ModInt& b)
+    { return a._v == b._v; }
+    friend constexpr bool operator!=(const ModInt& a, const ModInt& b)
+    { return a._v != b._v; }
+    friend constexpr bool operator<(const ModInt& a, const ModInt& b)
+    { return a.val() < b.val(); }
+    friend constexpr bool operator<=(const ModInt& a, const ModInt& b)
+    { return a.val() <= b.val(); }
+    friend constexpr bool operator>(const ModInt& a, const ModInt& b)
+    { return a.val() > b.val(); }
+    friend constexpr bool operator>=(const ModInt& a, const ModInt& b)
+    { return a.val() >= b.val(); }
+
+    friend std::ostream& operator<<(std::ostream& os, const ModInt& a)
+    { return os << a.val(); }
+};
+
+// smallest primitive root of a prime P
+template <uint32_t P>
+constexpr uint32_t _primitive_root()
+{
+    uint32_t f[32], nf = 0, m = P-1;
+    for (uint32_t d = 2; (uint64_t) d*d <= m; ++d)
+        if (m % d == 0)
+        {
+            f[nf++] = d;
+            while (m % d == 0)
+                m /= d;
+        }
+    if (m > 1)
+        f[nf++] = m;
+    for (uint32_t g = 2;; ++g)
+    {
+        bool ok = true;
+        for (uint32_t i = 0; i < nf && ok; ++i)
+            ok = ModInt<P>(g).pow((P-1)/f[i]) != 1;
+        if (ok)
+            return g;
+    }
+}
+
+// twiddle tables for the transforms modulo P
+template <uint32_t P>
+class _ntt_tables
+{
+    typedef ModInt<P> M;
+
+public:
+    static constexpr uint32_t G = _primitive_root<P>();
+    static constexpr uint32_t K = __builtin_ctz(P-1); // max length 2^K
+    // w[k] (see above), its inverse, and w[k]*w[2k] with inverse for radix 4
+    std::vector<M> w, iw, w3, iw3;
+    // per lane twiddles of the last radix 4 level (block size 4) for the
+    // vector code, t1[4k..4k+3] = 1,w[2k],w[k],w3[k] (inverses in it1)
+    std::vector<M> t1, it1;
+    M imag, iimag; // 4th root of unity i and i^-1
+
+    _ntt_tables(): w(1,1), iw(1,1), w3(1,1), iw3(1,1)
+    {
+        static_assert(K >= 2);
+        imag = M(G).pow((P-1)/4);
+        iimag = ~imag;
+    }
+
+    // tables for transforms of length n
+    void grow(size_t n)
+    {
+        assert(n <= ((size_t) 1 << K));
+        const size_t old = w.size();
+        if (n/2 <= old)
+            return;
+        w.resize(n/2);
+        iw.resize(n/2);
+        // w[2^j + t] = w[t] * (primitive 2^(j+2)-th root)
+        for (size_t h = old; h < n/2; h *= 2)
+        {
+            const uint32_t j = __builtin_ctzll(h);
+            const M r = M(G).pow((P-1) >> (j+2)), ir = ~r;
+            for (size_t t = 0; t < h; ++t)
+            {
+                w[h+t] = w[t]*r;
+                iw[h+t] = iw[t]*ir;
+            }
+        }
+        // radix 4 blocks use indices k < n/4
+        w3.resize(n/4);
+        iw3.resize(n/4);
+        t1.resize(n);
+        it1.resize(n);
+        for (size_t k = 0; k < n/4; ++k)
+        {
+            w3[k] = w[k]*w[2*k];
+            iw3[k] = iw[k]*iw[2*k];
+            t1[4*k] = it1[4*k] = 1;
+            t1[4*k+1] = w[2*k];
+            t1[4*k+2] = w[k];
+            t1[4*k+3] = w3[k];
+            it1[4*k+1] = iw[2*k];
+            it1[4*k+2] = iw[k];
+            it1[4*k+3] = iw3[k];
+        }
+    }
+
+    static _ntt_tables& get()
+    {
+        static _ntt_tables tables;
+        return tables;
+    }
+};
+
+template <uint32_t P>
+static void _ntt_scalar(ModInt<P> *a, size_t n, const _ntt_tables<P>& tb)
+{
+    typedef ModInt<P> M;
+    const M *w = tb.w.data(), *w3 = tb.w3.data();
+    const M imag = tb.imag;
+    size_t len = n; // block size
+    if (__builtin_ctzll(n) % 2) // radix 2 level with w[0] = 1
+    {
+        for (size_t j = 0; j < n/2; ++j)
+        {
+            const M u = a[j], v = a[j+n/2];
+            a[j] = u+v;
+            a[j+n/2] = u-v;
+        }
+        len /= 2;
+    }
+    for (; len >= 4; len /= 4)
+    {
+        const size_t m = len/4;
+        for (size_t s = 0, k = 0; s < n; s += len, ++k)
+        {
+            const M w1 = w[2*k], w2 = w[k], ww3 = w3[k];
+            M *b = a+s;
+            for (size_t j = 0; j < m; ++j)
+            {
+                const M a0 = b[j], b1 = b[j+m]*w1, b2 = b[j+2*m]*w2,
+                    b3 = b[j+3*m]*ww3;
+                const M x = a0+b2, y = a0-b2, z = b1+b3, t = (b1-b3)*imag;
+                b[j] = x+z;
+                b[j+m] = x-z;
+                b[j+2*m] = y+t;
+                b[j+3*m] = y-t;
+            }
+        }
+    }
+}
+
+template <uint32_t P>
+static void _intt_scalar(ModInt<P> *a, size_t n, const _ntt_tables<P>& tb)
+{
+    typedef ModInt<P> M;
+    const M *iw = tb.iw.data(), *iw3 = tb.iw3.data();
+    const M iimag = tb.iimag;
+    const size_t top = __builtin_ctzll(n) % 2 ? n/2 : n; // radix 4 up to top
+    for (size_t len = 4; len <= top; len *= 4)
+    {
+        const size_t m = len/4;
+        for (size_t s = 0, k = 0; s < n; s += len, ++k)
+        {
+            const M iw1 = iw[2*k], iw2 = iw[k], iww3 = iw3[k];
+            M *b = a+s;
+            for (size_t j = 0; j < m; ++j)
+            {
+                const M c0 = b[j], c1 = b[j+m], c2 = b[j+2*m], c3 = b[j+3*m];
+                // x = 2(a0+b2), y = 2(a0-b2), z = 2(b1+b3), t = 2(b1-b3)
+                const M x = c0+c1, z = c0-c1, y = c2+c3, t = (c2-c3)*iimag;
+                b[j] = x+y;
+                b[j+m] = (z+t)*iw1;
+                b[j+2*m] = (x-y)*iw2;
+                b[j+3*m] = (z-t)*iww3;
+            }
+        }
+    }
+    if (top != n)
+        for (size_t j = 0; j < n/2; ++j)
+        {
+            const M u = a[j], v = a[j+n/2];
+            a[j] = u+v;
+            a[j+n/2] = u-v;
+        }
+    const M inv_n = M((P+1)/2).pow(__builtin_ctzll(n));
+    for (size_t i = 0; i < n; ++i)
+        a[i] *= inv_n;
+}
+
+// AVX2 on 8 lanes of montgomery values (as in cpp/modint/modint_simd.cpp)
+
+template <uint32_t P>
+struct _avx2_mod
+{
+    // P^-1 mod 2^32
+    static constexpr uint32_t _inv()
+    {
+        uint32_t inv = P;
+        for (int i = 0; i < 4; ++i)
+            inv *= 2 - P*inv;
+        return inv;
+    }
+
+    __attribute__((target("avx2")))
+    static __m256i add(__m256i a, __m256i b)
+    {
+        const __m256i s = _mm256_add_epi32(a,b);
+        return _mm256_min_epu32(s,_mm256_sub_epi32(s,_mm256_set1_epi32(P)));
+    }
+
+    __attribute__((target("avx2")))
+    static __m256i sub(__m256i a, __m256i b)
+    {
+        const __m256i d = _mm256_sub_epi32(a,b);
+        return _mm256_min_epu32(d,_mm256_add_epi32(d,_mm256_set1_epi32(P)));
+    }
+
+    __attribute__((target("avx2")))
+    static __m256i mul(__m256i a, __m256i b)
+    {
+        const __m256i p = _mm256_set1_epi32(P);
+        const __m256i pinv = _mm256_set1_epi32(_inv());
+        const __m256i te = _mm256_mul_epu32(a,b);
+        const __m256i to = _mm256_mul_epu32(_mm256_srli_epi64(a,32),
+            _mm256_srli_epi64(b,32));
+        const __m256i ue = _mm256_mul_epu32(_mm256_mul_epu32(te,pinv),p);
+        const __m256i uo = _mm256_mul_epu32(_mm256_mul_epu32(to,pinv),p);
+        const __m256i re = _mm256_srli_epi64(_mm256_sub_epi64(te,ue),32);
+        const __m256i ro = _mm256_sub_epi64(to,uo);
+        const __m256i r = _mm256_blend_epi32(re,ro,0xaa);
+        return _mm256_min_epu32(r,_mm256_add_epi32(r,p));
+    }
+
+    // a*w for a broadcast w with wp = w*P^-1 mod 2^32 (also broadcast), so
+    // the quotients q = a*wp do not wait on the product a*w
+    __attribute__((target("avx2")))
+    static __m256i mul_const(__m256i a, __m256i w, __m256i wp)
+    {
+        const __m256i p = _mm256_set1_epi32(P);
+        const __m256i ao = _mm256_srli_epi64(a,32);
+        const __m256i te = _mm256_mul_epu32(a,w), to = _mm256_mul_epu32(ao,w);
+        const __m256i ue = _mm256_mul_epu32(_mm256_mul_epu32(a,wp),p);
+        const __m256i uo = _mm256_mul_epu32(_mm256_mul_epu32(ao,wp),p);
+        const __m256i re = _mm256_srli_epi64(_mm256_sub_epi64(te,ue),32);
+        const __m256i ro = _mm256_sub_epi64(to,uo);
+        const __m256i r = _mm256_blend_epi32(re,ro,0xaa);
+        return _mm256_min_epu32(r,_mm256_add_epi32(r,p));
+    }
+
+    // broadcast w and w*P^-1 for mul_const
+    struct cw { __m256i w, wp; };
+    __attribute__((target("avx2")))
+    static cw bconst(uint32_t w)
+    {
+        return {_mm256_set1_epi32(w),_mm256_set1_epi32(w*_inv())};
+    }
+
+    __attribute__((target("avx2")))
+    static __m256i load(const uint32_t *p)
+    {
+        return _mm256_loadu_si256((const __m256i*) p);
+    }
+
+    __attribute__((target("avx2")))
+    static void store(uint32_t *p, __m256i v)
+    {
+        _mm256_storeu_si256((__m256i*) p,v);
+    }
+
+    // lanes 0-3 from a and lanes 4-7 from b
+    __attribute__((target("avx2")))
+    static __m256i halves(uint32_t a, uint32_t b)
+    {
+        return _mm256_setr_epi32(a,a,a,a,b,b,b,b);
+    }
+};
+
+// radix 2 level on the halves of a (w = 1), used by both directions
+template <uint32_t P>
+__attribute__((target("avx2")))
+static void _radix2_avx2(uint32_t *a, size_t n)
+{
+    typedef _avx2_mod<P> V;
+    for (size_t j = 0; j < n/2; j += 8)
+    {
+        const __m256i u = V::load(a+j), v = V::load(a+j+n/2);
+        V::store(a+j,V::add(u,v));
+        V::store(a+j+n/2,V::sub(u,v));
+    }
+}
+
+// forward radix 4 level with block size len >= 64 on blocks in [lo,hi)
+template <uint32_t P>
+__attribute__((target("avx2")))
+static void _ntt_level_avx2(uint32_t *a, size_t lo, size_t hi, size_t len,
+    const _ntt_tables<P>& tb)
+{
+    typedef _avx2_mod<P> V;
+    const uint32_t *w = (const uint32_t*) tb.w.data();
+    const uint32_t *w3 = (const uint32_t*) tb.w3.data();
+    const auto [vi,vip] = V::bconst(*(const uint32_t*) &tb.imag);
+    const size_t m = len/4;
+    for (size_t s = lo, k = lo/len; s < hi; s += len, ++k)
+    {
+        const auto [w1,w1p] = V::bconst(w[2*k]);
+        const auto [w2,w2p] = V::bconst(w[k]);
+        const auto [ww3,ww3p] = V::bconst(w3[k]);
+        uint32_t *b = a+s;
+        for (size_t j = 0; j < m; j += 8)
+        {
+            const __m256i a0 = V::load(b+j);
+            const __m256i b1 = V::mul_const(V::load(b+j+m),w1,w1p);
+            const __m256i b2 = V::mul_const(V::load(b+j+2*m),w2,w2p);
+            const __m256i b3 = V::mul_const(V::load(b+j+3*m),ww3,ww3p);
+            const __m256i x = V::add(a0,b2), y = V::sub(a0,b2);
+            const __m256i z = V::add(b1,b3);
+            const __m256i t = V::mul_const(V::sub(b1,b3),vi,vip);
+            V::store(b+j,V::add(x,z));
+            V::store(b+j+m,V::sub(x,z));
+            V::store(b+j+2*m,V::add(y,t));
+            V::store(b+j+3*m,V::sub(y,t));
+        }
+    }
+}
+
+// forward radix 4 levels with block sizes 16 and 4 on [lo,hi), done within
+// registers with per lane twiddles
+template <uint32_t P>
+__attribute__((target("avx2")))
+static void _ntt_last_avx2(uint32_t *a, size_t lo, size_t hi,
+    const _ntt_tables<P>& tb)
+{
+    typedef _avx2_mod<P> V;
+    const uint32_t *w = (const uint32_t*) tb.w.data();
+    const uint32_t *w3 = (const uint32_t*) tb.w3.data();
+    const uint32_t *t1 = (const uint32_t*) tb.t1.data();
+    const uint32_t one = w[0], imag = *(const uint32_t*) &tb.imag;
+    // blocks of 16 as 2 registers [a0|a1], [a2|a3] of 4 lane quarters
+    const __m256i one_imag = V::halves(one,imag);
+    for (size_t s = lo, k = lo/16; s < hi; s += 16, ++k)
+    {
+        const __m256i l = V::mul(V::load(a+s),V::halves(one,w[2*k]));
+        const __m256i h = V::mul(V::load(a+s+8),V::halves(w[k],w3[k]));
+        const __m256i xz = V::add(l,h); // [x|z]
+        const __m256i yt = V::mul(V::sub(l,h),one_imag); // [y|t]
+        const __m256i zx = _mm256_permute2x128_si256(xz,xz,1);
+        const __m256i ty = _mm256_permute2x128_si256(yt,yt,1);
+        V::store(a+s,_mm256_blend_epi32(V::add(xz,zx),V::sub(zx,xz),0xf0));
+        V::store(a+s+8,_mm256_blend_epi32(V::add(yt,ty),V::sub(ty,yt),0xf0));
+    }
+    // blocks of 4, 2 per register
+    const __m256i imag3 = _mm256_setr_epi32(one,one,one,imag,one,one,one,imag);
+    for (size_t s = lo; s < hi; s += 8)
+    {
+        const __m256i b = V::mul(V::load(a+s),V::load(t1+s)); // a0 b1 b2 b3
+        const __m256i c = _mm256_shuffle_epi32(b,0x4e); // b2 b3 a0 b1
+        // x z y t
+        const __m256i d = V::mul(_mm256_blend_epi32(V::add(b,c),V::sub(c,b),
+            0xcc),imag3);
+        const __m256i e = _mm256_shuffle_epi32(d,0xb1); // z x t y
+        V::store(a+s,_mm256_blend_epi32(V::add(d,e),V::sub(e,d),0xaa));
+    }
+}
+
+// inverse radix 4 levels with block sizes 4 and 16 on [lo,hi)
+template <uint32_t P>
+__attribute__((target("avx2")))
+static void _intt_first_avx2(uint32_t *a, size_t lo, size_t hi,
+    const _ntt_tables<P>& tb)
+{
+    typedef _avx2_mod<P> V;
+    const uint32_t *iw = (const uint32_t*) tb.iw.data();
+    const uint32_t *iw3 = (const uint32_t*) tb.iw3.data();
+    const uint32_t *it1 = (const uint32_t*) tb.it1.data();
+    const uint32_t one = iw[0], iimag = *(const uint32_t*) &tb.iimag;
+    // blocks of 4
+    const __m256i iimag3 = _mm256_setr_epi32(one,one,one,iimag,
+        one,one,one,iimag);
+    for (size_t s = lo; s < hi; s += 8)
+    {
+        const __m256i c = V::load(a+s);
+        const __m256i d = _mm256_shuffle_epi32(c,0xb1); // c1 c0 c3 c2
+        // x z y t
+        const __m256i e = V::mul(_mm256_blend_epi32(V::add(c,d),V::sub(d,c),
+            0xaa),iimag3);
+        const __m256i f = _mm256_shuffle_epi32(e,0x4e); // y t x z
+        V::store(a+s,V::mul(_mm256_blend_epi32(V::add(e,f),V::sub(f,e),0xcc),
+            V::load(it1+s)));
+    }
+    // blocks of 16
+    const __m256i one_iimag = V::halves(one,iimag);
+    for (size_t s = lo, k = lo/16; s < hi; s += 16, ++k)
+    {
+        const __m256i c01 = V::load(a+s), c23 = V::load(a+s+8);
+        const __m256i c10 = _mm256_permute2x128_si256(c01,c01,1);
+        const __m256i c32 = _mm256_permute2x128_si256(c23,c23,1);
+        const __m256i xz = _mm256_blend_epi32(V::add(c01,c10),
+            V::sub(c10,c01),0xf0);
+        const __m256i yt = V::mul(_mm256_blend_epi32(V::add(c23,c32),
+            V::sub(c32,c23),0xf0),one_iimag);
+        V::store(a+s,V::mul(V::add(xz,yt),V::halves(one,iw[2*k])));
+        V::store(a+s+8,V::mul(V::sub(xz,yt),V::halves(iw[k],iw3[k])));
+    }
+}
+
+// inverse radix 4 level with block size len >= 64 on blocks in [lo,hi)
+template <uint32_t P>
+__attribute__((target("avx2")))
+static void _intt_level_avx2(uint32_t *a, size_t lo, size_t hi, size_t len,
+    const _ntt_tables<P>& tb)
+{
+    typedef _avx2_mod<P> V;
+    const uint32_t *iw = (const uint32_t*) tb.iw.data();
+    const uint32_t *iw3 = (const uint32_t*) tb.iw3.data();
+    const auto [vi,vip] = V::bconst(*(const uint32_t*) &tb.iimag);
+    const size_t m = len/4;
+    for (size_t s = lo, k = lo/len; s < hi; s += len, ++k)
+    {
+        const auto [iw1,iw1p] = V::bconst(iw[2*k]);
+        const auto [iw2,iw2p] = V::bconst(iw[k]);
+        const auto [iww3,iww3p] = V::bconst(iw3[k]);
+        uint32_t *b = a+s;
+        for (size_t j = 0; j < m; j += 8)
+        {
+            const __m256i c0 = V::load(b+j), c1 = V::load(b+j+m);
+            const __m256i c2 = V::load(b+j+2*m), c3 = V::load(b+j+3*m);
+            const __m256i x = V::add(c0,c1), z = V::sub(c0,c1);
+            const __m256i y = V::add(c2,c3);
+            const __m256i t = V::mul_const(V::sub(c2,c3),vi,vip);
+            V::store(b+j,V::add(x,y));
+            V::store(b+j+m,V::mul_const(V::add(z,t),iw1,iw1p));
+            V::store(b+j+2*m,V::mul_const(V::sub(x,y),iw2,iw2p));
+            V::store(b+j+3*m,V::mul_const(V::sub(z,t),iww3,iww3p));
+        }
+    }
+}
+
+// a[i] *= b[i]*c, or a[i] *= c when b is null (montgomery values, n >= 8)
+template <uint32_t P>
+__attribute__((target("avx2")))
+static void _pointwise_avx2(uint32_t *a, const uint32_t *b, size_t n,
+    uint32_t c)
+{
+    typedef _avx2_mod<P> V;
+    const __m256i vc = _mm256_set1_epi32(c);
+    for (size_t i = 0; i < n; i += 8)
+    {
+        const __m256i x = V::mul(V::load(a+i),vc);
+        V::store(a+i,b ? V::mul(x,V::load(b+i)) : x);
+    }
+}
+
+// levels on blocks up to this size (128 KiB) run one block at a time so the
+// block stays in cache, only the larger levels pass over the whole array
+static const size_t _NTT_CHUNK = 1 << 15;
+
+// forward transform for n >= 64
+template <uint32_t P>
+__attribute__((target("avx2")))
+static void _ntt_avx2(uint32_t *a, size_t n, const _ntt_tables<P>& tb)
+{
+    size_t len = n;
+    if (__builtin_ctzll(n) % 2)
+    {
+        _radix2_avx2<P>(a,n);
+        len /= 2;
+    }
+    for (; len > _NTT_CHUNK; len /= 4)
+        _ntt_level_avx2<P>(a,0,n,len,tb);
+    for (size_t c = 0; c < n; c += len)
+    {
+        for (size_t l = len; l >= 64; l /= 4)
+            _ntt_level_avx2<P>(a,c,c+len,l,tb);
+        _ntt_last_avx2<P>(a,c,c+len,tb);
+    }
+}
+
+// inverse transform for n >= 64, without the division by n
+template <uint32_t P>
+__attribute__((target("avx2")))
+static void _intt_avx2(uint32_t *a, size_t n, const _ntt_tables<P>& tb)
+{
+    const size_t top = __builtin_ctzll(n) % 2 ? n/2 : n; // radix 4 up to top
+    size_t len = top;
+    while (len > _NTT_CHUNK)
+        len /= 4;
+    for (size_t c = 0; c < n; c += len)
+    {
+        _intt_first_avx2<P>(a,c,c+len,tb);
+        for (size_t l = 64; l <= len; l *= 4)
+            _intt_level_avx2<P>(a,c,c+len,l,tb);
+    }
+    for (len *= 4; len <= top; len *= 4)
+        _intt_level_avx2<P>(a,0,n,len,tb);
+    if (top != n)
+        _radix2_avx2<P>(a,n);
+}
+
+static bool _has_avx2()
+{
+    static const bool ret = __builtin_cpu_supports("avx2");
+    return ret;
+}
+
+// forward transform of length n = 2^j, result in bit reversed order
+template <uint32_t P>
+void ntt(ModInt<P> *a, size_t n)
+{
+    static_assert(sizeof(ModInt<P>) == sizeof(uint32_t));
+    assert((n & (n-1)) == 0);
+    if (n <= 1)
+        return;
+    _ntt_tables<P>& tb = _ntt_tables<P>::get();
+    tb.grow(n);
+    if (n >= 64 && _has_avx2())
+        _ntt_avx2<P>((uint32_t*) a,n,tb);
+    else
+        _ntt_scalar<P>(a,n,tb);
+}
+
+// inverse of ntt (bit reversed input, natural order output) including the
+// division by n
+template <uint32_t P>
+void intt(ModInt<P> *a, size_t n)
+{
+    assert((n & (n-1)) == 0);
+    if (n <= 1)
+        return;
+    _ntt_tables<P>& tb = _ntt_tables<P>::get();
+    tb.grow(n);
+    if (n >= 64 && _has_avx2())
+    {
+        _intt_avx2<P>((uint32_t*) a,n,tb);
+        const ModInt<P> inv_n = ModInt<P>((P+1)/2).pow(__builtin_ctzll(n));
+        _pointwise_avx2<P>((uint32_t*) a,nullptr,n,*(const uint32_t*) &inv_n);
+    }
+    else
+        _intt_scalar<P>(a,n,tb);
+}
+
+// product of polynomials (coefficients in increasing degree order)
+template <uint32_t P>
+std::vector<ModInt<P>> convolution(const std::vector<ModInt<P>>& a,
+    const std::vector<ModInt<P>>& b)
+{
+    typedef ModInt<P> M;
+    if (a.empty() || b.empty())
+        return {};
+    const size_t len = a.size() + b.size() - 1;
+    if (std::min(a.size(),b.size()) <= 32) // schoolbook
+    {
+        std::vector<M> ret(len);
+        for (size_t i = 0; i < a.size(); ++i)
+            for (size_t j = 0; j < b.size(); ++j)
+                ret[i+j] += a[i]*b[j];
+        return ret;
+    }
+    size_t n = 1;
+    while (n < len)
+        n *= 2;
+    std::vector<M> fa(n), fb(n);
+    std::copy(a.begin(),a.end(),fa.begin());
+    std::copy(b.begin(),b.end(),fb.begin());
+    ntt(fa.data(),n);
+    ntt(fb.data(),n);
+    if (_has_avx2()) // n >= 128 here
+    {
+        // product and division by n in one pass
+        const M inv_n = M((P+1)/2).pow(__builtin_ctzll(n));
+        _pointwise_avx2<P>((uint32_t*) fa.data(),(const uint32_t*) fb.data(),
+            n,*(const uint32_t*) &inv_n);
+        _intt_avx2<P>((uint32_t*) fa.data(),n,_ntt_tables<P>::get());
+    }
+    else
+    {
+        for (size_t i = 0; i < n; ++i)
+            fa[i] *= fb[i];
+        intt(fa.data(),n);
+    }
+    fa.resize(len);
+    return fa;
+}
+
+// s*a + t*b = g = gcd(a,b) for nonzero a,b (bezout in py/exact_math/integer.py)
+constexpr int64_t _bezout(int64_t a, int64_t b, int64_t& s, int64_t& t)
+{
+    assert(a != 0 && b != 0);
+    int64_t r0 = a, r1 = b, s0 = 1, s1 = 0, t0 = 0, t1 = 1;
+    while (r1 != 0)
+    {
+        const int64_t q = r0/r1;
+        r0 -= q*r1;
+        s0 -= q*s1;
+        t0 -= q*t1;
+        std::swap(r0,r1);
+        std::swap(s0,s1);
+        std::swap(t0,t1);
+    }
+    s = r0 >= 0 ? s0 : -s0;
+    t = r0 >= 0 ? t0 : -t0;
+    return r0 >= 0 ? r0 : -r0;
+}
+
+// n^-1 mod m for gcd(n,m) = 1 (modinv in py/exact_math/integer.py)
+constexpr uint64_t _modinv(uint64_t n, uint64_t m)
+{
+    assert(m > 1 && n % m != 0); // 0 has no inverse
+    int64_t s = 0, t = 0;
+    const int64_t g = _bezout(n % m,m,s,t);
+    assert(g == 1); // not invertible
+    (void) g;
+    return s < 0 ? s + m : s;
+}
+
+static constexpr uint32_t _CRT_P1 = 167772161; // 5*2^25+1
+static constexpr uint32_t _CRT_P2 = 469762049; // 7*2^26+1
+static constexpr uint32_t _CRT_P3 = 754974721; // 45*2^24+1
+static_assert(_modinv(3,7) == 5 && _modinv(_CRT_P1,_CRT_P2) == 104391568);
+
+// coefficients mod P of the product of a and b (values < 2^32)
+template <uint32_t P>
+static std::vector<ModInt<P>> _convolution_residues(
+    const std::vector<uint32_t>& a, const std::vector<uint32_t>& b)
+{
+    std::vector<ModInt<P>> x(a.begin(),a.end()), y(b.begin(),b.end());
+    return convolution(x,y);
+}
+
+// product of polynomials modulo m < 2^31 (coefficients in [0,m), increasing
+// degree order), with 3 NTT primes and garner's algorithm
+std::vector<uint32_t> convolution_mod(const std::vector<uint32_t>& a,
+    const std::vector<uint32_t>& b, uint32_t m)
+{
+    assert(m >= 1 && m < (1u << 31));
+    if (a.empty() || b.empty())
+        return {};
+    const size_t len = a.size() + b.size() - 1;
+    // the exact coefficients must be below p1*p2*p3
+    const u128 prod = (u128) _CRT_P1*_CRT_P2*_CRT_P3;
+    assert((u128) std::min(a.size(),b.size())*(m-1)*(m-1) < prod);
+    assert(len <= (1u << 24));
+    (void) prod;
+    const std::vector<ModInt<_CRT_P1>> c1 = _convolution_residues<_CRT_P1>(a,b);
+    const std::vector<ModInt<_CRT_P2>> c2 = _convolution_residues<_CRT_P2>(a,b);
+    const std::vector<ModInt<_CRT_P3>> c3 = _convolution_residues<_CRT_P3>(a,b);
+    typedef ModInt<_CRT_P2> M2;
+    typedef ModInt<_CRT_P3> M3;
+    static constexpr uint64_t p12 = (uint64_t) _CRT_P1*_CRT_P2;
+    static constexpr M2 inv1 = M2(_modinv(_CRT_P1,_CRT_P2));
+    static constexpr M3 inv12 = M3(_modinv(p12 % _CRT_P3,_CRT_P3));
+    const uint64_t p12m = p12 % m;
+    std::vector<uint32_t> ret(len);
+    for (size_t i = 0; i < len; ++i)
+    {
+        const uint32_t x1 = c1[i].val();
+        const uint32_t x2 = ((c2[i] - x1) * inv1).val();
+        const uint64_t y = x1 + (uint64_t) x2*_CRT_P1; // c mod p1*p2
+        const uint32_t x3 = ((c3[i] - y) * inv12).val();
+        ret[i] = (y % m + x3*p12m) % m;
+    }
+    return ret;
+}
+
+// complex number for the floating point FFT
+struct _cpx
+{
+    double re, im;
+};
+
+static inline _cpx operator+(_cpx a, _cpx b) { return {a.re+b.re,a.im+b.im}; }
+static inline _cpx operator-(_cpx a, _cpx b) { return {a.re-b.re,a.im-b.im}; }
+static inline _cpx operator*(_cpx a, _cpx b)
+{
+    return {a.re*b.re - a.im*b.im,a.re*b.im + a.im*b.re};
+}
+static inline _cpx _conj(_cpx a) { return {a.re,-a.im}; }
+
+// in place transform A[k] = sum a[j]*e^(2*pi*i*j*k/n) for n = 2^j (bit
+// reversal then radix 2 levels). roots[h+j] = e^(pi*i*j/h) for j < h is
+// computed directly in long double so the error does not build up.
+static void _fft(std::vector<_cpx>& a)
+{
+    static std::vector<_cpx> roots(2,{1,0});
+    const size_t n = a.size();
+    for (size_t h = roots.size()/2; h < n/2 || roots.size() < n; h *= 2)
+    {
+        roots.resize(4*h);
+        const long double pi = std::acos(-1.0L);
+        for (size_t j = 0; j < 2*h; ++j)
+            roots[2*h+j] = {(double) std::cos(pi*j/(2*h)),
+                (double) std::sin(pi*j/(2*h))};
+    }
+    for (size_t i = 1, j = 0; i < n; ++i)
+    {
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1)
+            j ^= bit;
+        j ^= bit;
+        if (i < j)
+            std::swap(a[i],a[j]);
+    }
+    for (size_t h = 1; h < n; h *= 2)
+        for (size_t s = 0; s < n; s += 2*h)
+            for (size_t j = 0; j < h; ++j)
+            {
+                const _cpx u = a[s+j], v = roots[h+j] * a[s+j+h];
+                a[s+j] = u + v;
+                a[s+j+h] = u - v;
+            }
+}
+
+// product of polynomials modulo m <= 2^30 with a floating point FFT
+std::vector<uint32_t> convolution_mod_fft(const std::vector<uint32_t>& a,
+    const std::vector<uint32_t>& b, uint32_t m)
+{
+    assert(m >= 1 && m <= (1u << 30));
+    if (a.empty() || b.empty())
+        return {};
+    const size_t len = a.size() + b.size() - 1;
+    size_t n = 1;
+    while (n < len)
+        n *= 2;
+    const uint32_t cut = 1 << 15;
+    // high parts in the real part and low parts in the imaginary part
+    std::vector<_cpx> fa(n,{0,0}), fb(n,{0,0});
+    for (size_t i = 0; i < a.size(); ++i)
+        fa[i] = {(double) (a[i] / cut),(double) (a[i] % cut)};
+    for (size_t i = 0; i < b.size(); ++i)
+        fb[i] = {(double) (b[i] / cut),(double) (b[i] % cut)};
+    _fft(fa);
+    _fft(fb);
+    // with j = -i mod n, (A[i] + conj(A[j]))/2 and (A[i] - conj(A[j]))/2i are
+    // the transforms of the high and low parts of a. storing at index j
+    // makes the second forward transform an inverse transform (times n).
+    std::vector<_cpx> hi(n), lo(n);
+    const double scale = 0.5 / n;
+    for (size_t i = 0; i < n; ++i)
+    {
+        const size_t j = (n - i) & (n - 1);
+        const _cpx h = (fa[i] + _conj(fa[j])) * _cpx{scale,0};
+        const _cpx l = (fa[i] - _conj(fa[j])) * _cpx{0,-scale};
+        hi[j] = h * fb[i]; // ah*bh + i*ah*bl
+        lo[j] = l * fb[i]; // al*bh + i*al*bl
+    }
+    _fft(hi);
+    _fft(lo);
+    std::vector<uint32_t> ret(len);
+    for (size_t i = 0; i < len; ++i)
+    {
+        const uint64_t hh = std::llround(hi[i].re) % m;
+        const uint64_t hl = (std::llround(hi[i].im) + std::llround(lo[i].re)) % m;
+        const uint64_t ll = std::llround(lo[i].im) % m;
+        ret[i] = ((hh*cut + hl) % m * cut + ll) % m;
+    }
+    return ret;
+}
+
+// schoolbook product modulo m for testing
+static std::vector<uint32_t> _convolution_naive(const std::vector<uint32_t>& a,
+    const std::vector<uint32_t>& b, uint32_t m)
+{
+    if (a.empty() || b.empty())
+        return {};
+    std::vector<uint64_t> c(a.size()+b.size()-1);
+    for (size_t i = 0; i < a.size(); ++i)
+        for (size_t j = 0; j < b.size(); ++j)
+            c[i+j] = (c[i+j] + (uint64_t) a[i]*b[j]) % m;
+    return std::vector<uint32_t>(c.begin(),c.end());
+}
+
+int main(int argc, char **argv)
+{
+    assert(convolution_mod({},{1},7).empty());
+    assert(convolution_mod({1,2,3},{4,5},7) == std::vector<uint32_t>({4,6,1,1}));
+    assert(convolution_mod_fft({1,2,3},{4,5},7)
+        == std::vector<uint32_t>({4,6,1,1}));
+    assert(convolution_mod({5},{6},1) == std::vector<uint32_t>({0}));
+    std::mt19937_64 rng(16);
+    for (uint32_t m : {2u,1000000007u,998244353u,(1u << 30),(1u << 31) - 1})
+        for (size_t la : {1,2,33,100,1000})
+            for (size_t lb : {1,7,64,999,2000})
+            {
+                std::vector<uint32_t> a(la), b(lb);
+                // maximal values most of the time to stress the bounds
+                for (uint32_t& x : a)
+                    x = rng() % 4 ? m-1 : rng() % m;
+                for (uint32_t& x : b)
+                    x = rng() % 4 ? m-1 : rng() % m;
+                const std::vector<uint32_t> c = _convolution_naive(a,b,m);
+                assert(convolution_mod(a,b,m) == c);
+                if (m <= (1u << 30))
+                    assert(convolution_mod_fft(a,b,m) == c);
+            }
+    // fft with transforms of length 2^20, where the coefficients reach 2^49
+    // and the rounding error of maximal values gets to about 0.4 (of 1/2)
+    for (uint32_t m : {(1u << 30),1000000007u})
+    {
+        std::vector<uint32_t> a(1 << 19), b((1 << 19) - 5);
+        for (uint32_t& x : a)
+            x = rng() % 8 ? m-1 : rng() % m;
+        for (uint32_t& x : b)
+            x = rng() % 8 ? m-1 : rng() % m;
+        assert(convolution_mod_fft(a,b,m) == convolution_mod(a,b,m));
+    }
+
+    // run with "bench" argument for timing
+    if (argc > 1 && std::string(argv[1]) == "bench")
+    {
+        const uint32_t m = 1000000007;
+        auto ms = [](auto s, auto t)
+        { return std::chrono::duration<double,std::milli>(t-s).count(); };
+        for (size_t n : {1 << 12, 1 << 16, 1 << 18, 1 << 20})
+        {
+            std::vector<uint32_t> a(n), b(n);
+            for (size_t i = 0; i < n; ++i)
+                a[i] = rng() % 4 ? m-1 : rng() % m, b[i] = rng() % m;
+            convolution_mod(a,b,m); // tables
+            convolution_mod_fft(a,b,m);
+            auto t0 = std::chrono::steady_clock::now();
+            const std::vector<uint32_t> c = convolution_mod(a,b,m);
+            auto t1 = std::chrono::steady_clock::now();
+            const std::vector<uint32_t> d = convolution_mod_fft(a,b,m);
+            auto t2 = std::chrono::steady_clock::now();
+            std::vector<uint32_t> e;
+            if (n <= (1 << 12))
+                e = _convolution_naive(a,b,m);
+            auto t3 = std::chrono::steady_clock::now();
+            // count fft rounding errors against the exact ntt result
+            size_t bad = 0;
+            for (size_t i = 0; i < c.size(); ++i)
+                bad += c[i] != d[i];
+            assert(e.empty() || e == c);
+            printf("n = %zu mod %u: 3 prime ntt %.2f ms, fft %.2f ms "
+                "(%zu wrong)",n,m,ms(t0,t1),ms(t1,t2),bad);
+            if (!e.empty())
+                printf(", naive %.2f ms",ms(t2,t3));
+            printf("\n");
+        }
+    }
+}
@@ -0,0 +1,1106 @@
+/*
+Multipoint evaluation and interpolation modulo an NTT friendly prime
+
+For points a_0..a_(m-1) (padded with zeros to n = 2^k) the subproduct tree
+stores the monic products P_v = prod (x - a_i) over the points below each node
+v, level by level: level l has n/2^l nodes of degree h = 2^l, stored as their h
+low coefficients (the leading 1 is implied) in one array of n values, and for
+h >= 32 also as NTT values of length 2h (2n values per level), which both
+building and the descents below reuse.
+
+Evaluation uses the transposed (tellegen) form of the remainder tree, which
+needs no polynomial division below the root. With mulT(g,t)_i = sum g_(i+j)*t_j
+and T_v(x) = x^deg P_v(1/x) = prod (1 - a_i x),
+  f(a_i) = mulT(f,1/(1 - a_i x))_0 = mulT(f,1/T_root * prod_(j != i) T_j)_0
+so starting from g_root = mulT(f,1/T_root) (one series inverse), each node
+passes g_L = mulT(g_v,T_R) to its left child and g_R = mulT(g_v,T_L) to its
+right child, keeping |child| terms, and leaf i ends with f(a_i). With g_v of
+length 2h, mulT(g_v,T_R)_i = (g_v*P_R)_(i+h), so a cyclic product of length 2h
+(3 transforms per node with the stored tree transforms) gives both children.
+
+Interpolation (distinct x_i) computes c_i = y_i/P'(x_i) with one multipoint
+evaluation, then sums c_i*P/(x - x_i) bottom up with R_v = R_L*P_R + R_R*P_L.
+The zero padding multiplies P and the sum by x^(n-m), which is shifted out.
+Both are O(n log^2 n). RatPoly in py/exact_math/ratpoly.py only has single
+point horner evaluation and no interpolation. The NTT engine and the series
+inverse are copied from cpp/poly/ntt.cpp and cpp/poly/fps.cpp.
+*/
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <ostream>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <immintrin.h>
+
+template <uint32_t P>
+class ModInt
+{
+    static_assert(P % 2 == 1 && P < (1u << 31),"P must be odd and below 2^31");
+
+    // -P^-1 mod 2^32 by newton iteration (each step doubles the correct bits)
+    static constexpr uint32_t _neg_inv()
+    {
+        uint32_t inv = P;
+        for (int i = 0; i < 4; ++i)
+            inv *= 2 - P*inv;
+        return -inv;
+    }
+
+    static constexpr uint32_t _NINV = _neg_inv();
+    static constexpr uint32_t _R2 = (uint32_t) (((__uint128_t) 1 << 64) % P);
+    uint32_t _v; // montgomery form, in [0,P)
+
+    // t*R^-1 mod P for t < P*2^32
+    static constexpr uint32_t _reduce(uint64_t t)
+    {
+        const uint32_t m = (uint32_t) t * _NINV;
+        const uint32_t r = (t + (uint64_t) m*P) >> 32; // < 2P
+        return r >= P ? r - P : r;
+    }
+
+    // integer to [0,P) including negative values
+    template <typename I>
+    static constexpr uint32_t _mod(I x)
+    {
+        static_assert(std::is_integral_v<I>);
+        if constexpr (std::is_signed_v<I>)
+        {
+            const int64_t r = (int64_t) x % (int64_t) P;
+            return r < 0 ? r + P : r;
+        }
+        else
+            return (uint64_t) x % P;
+    }
+
+    // value from montgomery form without conversion
+    static constexpr ModInt _raw(uint32_t v)
+    {
+        ModInt ret;
+        ret._v = v;
+        return ret;
+    }
+
+public:
+    constexpr ModInt(): _v(0) {}
+    template <typename I, typename = std::enable_if_t<std::is_integral_v<I>>>
+    constexpr ModInt(I x): _v(_reduce((uint64_t) _mod(x)*_R2)) {}
+
+    static constexpr uint32_t mod() { return P; }
+    // value in [0,P)
+    constexpr uint32_t val() const { return _reduce(_v); }
+    explicit constexpr operator uint32_t() const { return val(); }
+    explicit constexpr operator bool() const { return _v != 0; }
+
+    // arithmetic
+    constexpr ModInt& operator+=(const ModInt& o)
+    {
+        const uint32_t r = _v + o._v - P; // wraps below 0 when _v+o._v < P
+        _v = r + (-(r >> 31) & P);
+        return *this;
+    }
+    constexpr ModInt& operator-=(const ModInt& o)
+    {
+        const uint32_t r = _v - o._v;
+        _v = r + (-(r >> 31) & P);
+        return *this;
+    }
+    constexpr ModInt& operator*=(const ModInt& o)
+    {
+        _v = _reduce((uint64_t) _v*o._v);
+        return *this;
+    }
+    constexpr ModInt& operator/=(const ModInt& o) { return *this *= ~o; }
+
+    friend constexpr ModInt operator+(ModInt a, const ModInt& b)
+    { return a += b; }
+    friend constexpr ModInt operator-(ModInt a, const ModInt& b)
+    { return a -= b; }
+    friend constexpr ModInt operator*(ModInt a, const ModInt& b)
+    { return a *= b; }
+    friend constexpr ModInt operator/(ModInt a, const ModInt& b)
+    { return a /= b; }
+
+    constexpr ModInt operator+() const { return *this; }
+    constexpr ModInt operator-() const { return ModInt() - *this; }
+
+    // inverse with the extended euclidean algorithm (P may be composite)
+    constexpr ModInt operator~() const
+    {
+        assert(P > 1 && _v != 0); // 0 has no inverse
+        int64_t r0 = val(), r1 = P, s0 = 1, s1 = 0;
+        while (r1)
+        {
+            const int64_t q = r0/r1;
+            r0 -= q*r1;
+            s0 -= q*s1;
+            std::swap(r0,r1);
+            std::swap(s0,s1);
+        }
+        assert(r0 == 1); // not invertible
+        return ModInt(s0);
+    }
+
+    // power, negative exponents use the inverse
+    constexpr ModInt pow(int64_t e) const
+    {
+        ModInt b = e < 0 ? ~*this : *this, ret = _raw(_reduce(_R2));
+        uint64_t k = e < 0 ? -(uint64_t) e : e;
+        for (; k; k >>= 1, b *= b)
+            if (k & 1)
+                ret *= b;
+        return P == 1 ? ModInt() : ret;
+    }
+
+    // comparisons by value (montgomery form is a bijection so == is direct)
+    friend constexpr bool operator==(const ModInt& a, const ModInt& b)
+    { return a._v == b._v; }
+    friend constexpr bool operator!=(const ModInt& a, const ModInt& b)
+    { return a._v != b._v; }
+    friend constexpr bool operator<(const ModInt& a, const ModInt& b)
+    { return a.val() < b.val(); }
+    friend constexpr bool operator<=(const ModInt& a, const ModInt& b)
+    { return a.val() <= b.val(); }
+    friend constexpr bool operator>(const ModInt& a, const ModInt& b)
+    { return a.val() > b.val(); }
+    friend constexpr bool operator>=(const ModInt& a, const ModInt& b)
+    { return a.val() >= b.val(); }
+
+    friend std::ostream& operator<<(std::ostream& os, const ModInt& a)
+    { return os << a.val(); }
+};
+
+// smallest primitive root of a prime P
+template <uint32_t P>
+constexpr uint32_t _primitive_root()
+{
+    uint32_t f[32], nf = 0, m = P-1;
+    for (uint32_t d = 2; (uint64_t) d*d <= m; ++d)
+        if (m % d == 0)
+        {
+            f[nf++] = d;
+            while (m % d == 0)
+                m /= d;
+        }
+    if (m > 1)
+        f[nf++] = m;
+    for (uint32_t g = 2;; ++g)
+    {
+        bool ok = true;
+        for (uint32_t i = 0; i < nf && ok; ++i)
+            ok = ModInt<P>(g).pow((P-1)/f[i]) != 1;
+        if (ok)
+            return g;
+    }
+}
+
+// twiddle tables for the transforms modulo P
+template <uint32_t P>
+class _ntt_tables
+{
+    typedef ModInt<P> M;
+
+public:
+    static constexpr uint32_t G = _primitive_root<P>();
+    static constexpr uint32_t K = __builtin_ctz(P-1); // max length 2^K
+    // w[k] (see above), its inverse, and w[k]*w[2k] with inverse for radix 4
+    std::vector<M> w, iw, w3, iw3;
+    // per lane twiddles of the last radix 4 level (block size 4) for the
+    // vector code, t1[4k..4k+3] = 1,w[2k],w[k],w3[k] (inverses in it1)
+    std::vector<M> t1, it1;
+    M imag, iimag; // 4th root of unity i and i^-1
+
+    _ntt_tables(): w(1,1), iw(1,1), w3(1,1), iw3(1,1)
+    {
+        static_assert(K >= 2);
+        imag = M(G).pow((P-1)/4);
+        iimag = ~imag;
+    }
+
+    // tables for transforms of length n
+    void grow(size_t n)
+    {
+        assert(n <= ((size_t) 1 << K));
+        const size_t old = w.size();
+        if (n/2 <= old)
+            return;
+        w.resize(n/2);
+        iw.resize(n/2);
+        // w[2^j + t] = w[t] * (primitive 2^(j+2)-th root)
+        for (size_t h = old; h < n/2; h *= 2)
+        {
+            const uint32_t j = __builtin_ctzll(h);
+            const M r = M(G).pow((P-1) >> (j+2)), ir = ~r;
+            for (size_t t = 0; t < h; ++t)
+            {
+                w[h+t] = w[t]*r;
+                iw[h+t] = iw[t]*ir;
+            }
+        }
+        // radix 4 blocks use indices k < n/4
+        w3.resize(n/4);
+        iw3.resize(n/4);
+        t1.resize(n);
+        it1.resize(n);
+        for (size_t k = 0; k < n/4; ++k)
+        {
+            w3[k] = w[k]*w[2*k];
+            iw3[k] = iw[k]*iw[2*k];
+            t1[4*k] = it1[4*k] = 1;
+            t1[4*k+1] = w[2*k];
+            t1[4*k+2] = w[k];
+            t1[4*k+3] = w3[k];
+            it1[4*k+1] = iw[2*k];
+            it1[4*k+2] = iw[k];
+            it1[4*k+3] = iw3[k];
+        }
+    }
+
+    static _ntt_tables& get()
+    {
+        static _ntt_tables tables;
+        return tables;
+    }
+};
+
+template <uint32_t P>
+static void _ntt_scalar(ModInt<P> *a, size_t n, const _ntt_tables<P>& tb)
+{
+    typedef ModInt<P> M;
+    const M *w = tb.w.data(), *w3 = tb.w3.data();
+    const M imag = tb.imag;
+    size_t len = n; // block size
+    if (__builtin_ctzll(n) % 2) // radix 2 level with w[0] = 1
+    {
+        for (size_t j = 0; j < n/2; ++j)
+        {
+            const M u = a[j], v = a[j+n/2];
+            a[j] = u+v;
+            a[j+n/2] = u-v;
+        }
+        len /= 2;
+    }
+    for (; len >= 4; len /= 4)
+    {
+        const size_t m = len/4;
+        for (size_t s = 0, k = 0; s < n; s += len, ++k)
+        {
+            const M w1 = w[2*k], w2 = w[k], ww3 = w3[k];
+            M *b = a+s;
+            for (size_t j = 0; j < m; ++j)
+            {
+                const M a0 = b[j], b1 = b[j+m]*w1, b2 = b[j+2*m]*w2,
+                    b3 = b[j+3*m]*ww3;
+                const M x = a0+b2, y = a0-b2, z = b1+b3, t = (b1-b3)*imag;
+                b[j] = x+z;
+                b[j+m] = x-z;
+                b[j+2*m] = y+t;
+                b[j+3*m] = y-t;
+            }
+        }
+    }
+}
+
+template <uint32_t P>
+static void _intt_scalar(ModInt<P> *a, size_t n, const _ntt_tables<P>& tb)
+{
+    typedef ModInt<P> M;
+    const M *iw = tb.iw.data(), *iw3 = tb.iw3.data();
+    const M iimag = tb.iimag;
+    const size_t top = __builtin_ctzll(n) % 2 ? n/2 : n; // radix 4 up to top
+    for (size_t len = 4; len <= top; len *= 4)
+    {
+        const size_t m = len/4;
+        for (size_t s = 0, k = 0; s < n; s += len, ++k)
+        {
+            const M iw1 = iw[2*k], iw2 = iw[k], iww3 = iw3[k];
+            M *b = a+s;
+            for (size_t j = 0; j < m; ++j)
+            {
+                const M c0 = b[j], c1 = b[j+m], c2 = b[j+2*m], c3 = b[j+3*m];
+                // x = 2(a0+b2), y = 2(a0-b2), z = 2(b1+b3), t = 2(b1-b3)
+                const M x = c0+c1, z = c0-c1, y = c2+c3, t = (c2-c3)*iimag;
+                b[j] = x+y;
+                b[j+m] = (z+t)*iw1;
+                b[j+2*m] = (x-y)*iw2;
+                b[j+3*m] = (z-t)*iww3;
+            }
+        }
+    }
+    if (top != n)
+        for (size_t j = 0; j < n/2; ++j)
+        {
+            const M u = a[j], v = a[j+n/2];
+            a[j] = u+v;
+            a[j+n/2] = u-v;
+        }
+    const M inv_n = M((P+1)/2).pow(__builtin_ctzll(n));
+    for (size_t i = 0; i < n; ++i)
+        a[i] *= inv_n;
+}
+
+// AVX2 on 8 lanes of montgomery values (as in cpp/modint/modint_simd.cpp)
+
+template <uint32_t P>
+struct _avx2_mod
+{
+    // P^-1 mod 2^32
+    static constexpr uint32_t _inv()
+    {
+        uint32_t inv = P;
+        for (int i = 0; i < 4; ++i)
+            inv *= 2 - P*inv;
+        return inv;
+    }
+
+    __attribute__((target("avx2")))
+    static __m256i add(__m256i a, __m256i b)
+    {
+        const __m256i s = _mm256_add_epi32(a,b);
+        return _mm256_min_epu32(s,_mm256_sub_epi32(s,_mm256_set1_epi32(P)));
+    }
+
+    __attribute__((target("avx2")))
+    static __m256i sub(__m256i a, __m256i b)
+    {
+        const __m256i d = _mm256_sub_epi32(a,b);
+        return _mm256_min_epu32(d,_mm256_add_epi32(d,_mm256_set1_epi32(P)));
+    }
+
+    __attribute__((target("avx2")))
+    static __m256i mul(__m256i a, __m256i b)
+    {
+        const __m256i p = _mm256_set1_epi32(P);
+        const __m256i pinv = _mm256_set1_epi32(_inv());
+        const __m256i te = _mm256_mul_epu32(a,b);
+        const __m256i to = _mm256_mul_epu32(_mm256_srli_epi64(a,32),
+            _mm256_srli_epi64(b,32));
+        const __m256i ue = _mm256_mul_epu32(_mm256_mul_epu32(te,pinv),p);
+        const __m256i uo = _mm256_mul_epu32(_mm256_mul_epu32(to,pinv),p);
+        const __m256i re = _mm256_srli_epi64(_mm256_sub_epi64(te,ue),32);
+        const __m256i ro = _mm256_sub_epi64(to,uo);
+        const __m256i r = _mm256_blend_epi32(re,ro,0xaa);
+        return _mm256_min_epu32(r,_mm256_add_epi32(r,p));
+    }
+
+    // a*w for a broadcast w with wp = w*P^-1 mod 2^32 (also broadcast), so
+    // the quotients q = a*wp do not wait on the product a*w
+    __attribute__((target("avx2")))
+    static __m256i mul_const(__m256i a, __m256i w, __m256i wp)
+    {
+        const __m256i p = _mm256_set1_epi32(P);
+        const __m256i ao = _mm256_srli_epi64(a,32);
+        const __m256i te = _mm256_mul_epu32(a,w), to = _mm256_mul_epu32(ao,w);
+        const __m256i ue = _mm256_mul_epu32(_mm256_mul_epu32(a,wp),p);
+        const __m256i uo = _mm256_mul_epu32(_mm256_mul_epu32(ao,wp),p);
+        const __m256i re = _mm256_srli_epi64(_mm256_sub_epi64(te,ue),32);
+        const __m256i ro = _mm256_sub_epi64(to,uo);
+        const __m256i r = _mm256_blend_epi32(re,ro,0xaa);
+        return _mm256_min_epu32(r,_mm256_add_epi32(r,p));
+    }
+
+    // broadcast w and w*P^-1 for mul_const
+    struct cw { __m256i w, wp; };
+    __attribute__((target("avx2")))
+    static cw bconst(uint32_t w)
+    {
+        return {_mm256_set1_epi32(w),_mm256_set1_epi32(w*_inv())};
+    }
+
+    __attribute__((target("avx2")))
+    static __m256i load(const uint32_t *p)
+    {
+        return _mm256_loadu_si256((const __m256i*) p);
+    }
+
+    __attribute__((target("avx2")))
+    static void store(uint32_t *p, __m256i v)
+    {
+        _mm256_storeu_si256((__m256i*) p,v);
+    }
+
+    // lanes 0-3 from a and lanes 4-7 from b
+    __attribute__((target("avx2")))
+    static __m256i halves(uint32_t a, uint32_t b)
+    {
+        return _mm256_setr_epi32(a,a,a,a,b,b,b,b);
+    }
+};
+
+// radix 2 level on the halves of a (w = 1), used by both directions
+template <uint32_t P>
+__attribute__((target("avx2")))
+static void _radix2_avx2(uint32_t *a, size_t n)
+{
+    typedef _avx2_mod<P> V;
+    for (size_t j = 0; j < n/2; j += 8)
+    {
+        const __m256i u = V::load(a+j), v = V::load(a+j+n/2);
+        V::store(a+j,V::add(u,v));
+        V::store(a+j+n/2,V::sub(u,v));
+    }
+}
+
+// forward radix 4 level with block size len >= 64 on blocks in [lo,hi)
+template <uint32_t P>
+__attribute__((target("avx2")))
+static void _ntt_level_avx2(uint32_t *a, size_t lo, size_t hi, size_t len,
+    const _ntt_tables<P>& tb)
+{
+    typedef _avx2_mod<P> V;
+    const uint32_t *w = (const uint32_t*) tb.w.data();
+    const uint32_t *w3 = (const uint32_t*) tb.w3.data();
+    const auto [vi,vip] = V::bconst(*(const uint32_t*) &tb.imag);
+    const size_t m = len/4;
+    for (size_t s = lo, k = lo/len; s < hi; s += len, ++k)
+    {
+        const auto [w1,w1p] = V::bconst(w[2*k]);
+        const auto [w2,w2p] = V::bconst(w[k]);
+        const auto [ww3,ww3p] = V::bconst(w3[k]);
+        uint32_t *b = a+s;
+        for (size_t j = 0; j < m; j += 8)
+        {
+            const __m256i a0 = V::load(b+j);
+            const __m256i b1 = V::mul_const(V::load(b+j+m),w1,w1p);
+            const __m256i b2 = V::mul_const(V::load(b+j+2*m),w2,w2p);
+            const __m256i b3 = V::mul_const(V::load(b+j+3*m),ww3,ww3p);
+            const __m256i x = V::add(a0,b2), y = V::sub(a0,b2);
+            const __m256i z = V::add(b1,b3);
+            const __m256i t = V::mul_const(V::sub(b1,b3),vi,vip);
+            V::store(b+j,V::add(x,z));
+            V::store(b+j+m,V::sub(x,z));
+            V::store(b+j+2*m,V::add(y,t));
+            V::store(b+j+3*m,V::sub(y,t));
+        }
+    }
+}
+
+// forward radix 4 levels with block sizes 16 and 4 on [lo,hi), done within
+// registers with per lane twiddles
+template <uint32_t P>
+__attribute__((target("avx2")))
+static void _ntt_last_avx2(uint32_t *a, size_t lo, size_t hi,
+    const _ntt_tables<P>& tb)
+{
+    typedef _avx2_mod<P> V;
+    const uint32_t *w = (const uint32_t*) tb.w.data();
+    const uint32_t *w3 = (const uint32_t*) tb.w3.data();
+    const uint32_t *t1 = (const uint32_t*) tb.t1.data();
+    const uint32_t one = w[0], imag = *(const uint32_t*) &tb.imag;
+    // blocks of 16 as 2 registers [a0|a1], [a2|a3] of 4 lane quarters
+    const __m256i one_imag = V::halves(one,imag);
+    for (size_t s = lo, k = lo/16; s < hi; s += 16, ++k)
+    {
+        const __m256i l = V::mul(V::load(a+s),V::halves(one,w[2*k]));
+        const __m256i h = V::mul(V::load(a+s+8),V::halves(w[k],w3[k]));
+        const __m256i xz = V::add(l,h); // [x|z]
+        const __m256i yt = V::mul(V::sub(l,h),one_imag); // [y|t]
+        const __m256i zx = _mm256_permute2x128_si256(xz,xz,1);
+        const __m256i ty = _mm256_permute2x128_si256(yt,yt,1);
+        V::store(a+s,_mm256_blend_epi32(V::add(xz,zx),V::sub(zx,xz),0xf0));
+        V::store(a+s+8,_mm256_blend_epi32(V::add(yt,ty),V::sub(ty,yt),0xf0));
+    }
+    // blocks of 4, 2 per register
+    const __m256i imag3 = _mm256_setr_epi32(one,one,one,imag,one,one,one,imag);
+    for (size_t s = lo; s < hi; s += 8)
+    {
+        const __m256i b = V::mul(V::load(a+s),V::load(t1+s)); // a0 b1 b2 b3
+        const __m256i c = _mm256_shuffle_epi32(b,0x4e); // b2 b3 a0 b1
+        // x z y t
+        const __m256i d = V::mul(_mm256_blend_epi32(V::add(b,c),V::sub(c,b),
+            0xcc),imag3);
+        const __m256i e = _mm256_shuffle_epi32(d,0xb1); // z x t y
+        V::store(a+s,_mm256_blend_epi32(V::add(d,e),V::sub(e,d),0xaa));
+    }
+}
+
+// inverse radix 4 levels with block sizes 4 and 16 on [lo,hi)
+template <uint32_t P>
+__attribute__((target("avx2")))
+static void _intt_first_avx2(uint32_t *a, size_t lo, size_t hi,
+    const _ntt_tables<P>& tb)
+{
+    typedef _avx2_mod<P> V;
+    const uint32_t *iw = (const uint32_t*) tb.iw.data();
+    const uint32_t *iw3 = (const uint32_t*) tb.iw3.data();
+    const uint32_t *it1 = (const uint32_t*) tb.it1.data();
+    const uint32_t one = iw[0], iimag = *(const uint32_t*) &tb.iimag;
+    // blocks of 4
+    const __m256i iimag3 = _mm256_setr_epi32(one,one,one,iimag,
+        one,one,one,iimag);
+    for (size_t s = lo; s < hi; s += 8)
+    {
+        const __m256i c = V::load(a+s);
+        const __m256i d = _mm256_shuffle_epi32(c,0xb1); // c1 c0 c3 c2
+        // x z y t
+        const __m256i e = V::mul(_mm256_blend_epi32(V::add(c,d),V::sub(d,c),
+            0xaa),iimag3);
+        const __m256i f = _mm256_shuffle_epi32(e,0x4e); // y t x z
+        V::store(a+s,V::mul(_mm256_blend_epi32(V::add(e,f),V::sub(f,e),0xcc),
+            V::load(it1+s)));
+    }
+    // blocks of 16
+    const __m256i one_iimag = V::halves(one,iimag);
+    for (size_t s = lo, k = lo/16; s < hi; s += 16, ++k)
+    {
+        const __m256i c01 = V::load(a+s), c23 = V::load(a+s+8);
+        const __m256i c10 = _mm256_permute2x128_si256(c01,c01,1);
+        const __m256i c32 = _mm256_permute2x128_si256(c23,c23,1);
+        const __m256i xz = _mm256_blend_epi32(V::add(c01,c10),
+            V::sub(c10,c01),0xf0);
+        const __m256i yt = V::mul(_mm256_blend_epi32(V::add(c23,c32),
+            V::sub(c32,c23),0xf0),one_iimag);
+        V::store(a+s,V::mul(V::add(xz,yt),V::halves(one,iw[2*k])));
+        V::store(a+s+8,V::mul(V::sub(xz,yt),V::halves(iw[k],iw3[k])));
+    }
+}
+
+// inverse radix 4 level with block size len >= 64 on blocks in [lo,hi)
+template <uint32_t P>
+__attribute__((target("avx2")))
+static void _intt_level_avx2(uint32_t *a, size_t lo, size_t hi, size_t len,
+    const _ntt_tables<P>& tb)
+{
+    typedef _avx2_mod<P> V;
+    const uint32_t *iw = (const uint32_t*) tb.iw.data();
+    const uint32_t *iw3 = (const uint32_t*) tb.iw3.data();
+    const auto [vi,vip] = V::bconst(*(const uint32_t*) &tb.iimag);
+    const size_t m = len/4;
+    for (size_t s = lo, k = lo/len; s < hi; s += len, ++k)
+    {
+        const auto [iw1,iw1p] = V::bconst(iw[2*k]);
+        const auto [iw2,iw2p] = V::bconst(iw[k]);
+        const auto [iww3,iww3p] = V::bconst(iw3[k]);
+        uint32_t *b = a+s;
+        for (size_t j = 0; j < m; j += 8)
+        {
+            const __m256i c0 = V::load(b+j), c1 = V::load(b+j+m);
+            const __m256i c2 = V::load(b+j+2*m), c3 = V::load(b+j+3*m);
+            const __m256i x = V::add(c0,c1), z = V::sub(c0,c1);
+            const __m256i y = V::add(c2,c3);
+            const __m256i t = V::mul_const(V::sub(c2,c3),vi,vip);
+            V::store(b+j,V::add(x,y));
+            V::store(b+j+m,V::mul_const(V::add(z,t),iw1,iw1p));
+            V::store(b+j+2*m,V::mul_const(V::sub(x,y),iw2,iw2p));
+            V::store(b+j+3*m,V::mul_const(V::sub(z,t),iww3,iww3p));
+        }
+    }
+}
+
+// a[i] *= b[i]*c, or a[i] *= c when b is null (montgomery values, n >= 8)
+template <uint32_t P>
+__attribute__((target("avx2")))
+static void _pointwise_avx2(uint32_t *a, const uint32_t *b, size_t n,
+    uint32_t c)
+{
+    typedef _avx2_mod<P> V;
+    const __m256i vc = _mm256_set1_epi32(c);
+    for (size_t i = 0; i < n; i += 8)
+    {
+        const __m256i x = V::mul(V::load(a+i),vc);
+        V::store(a+i,b ? V::mul(x,V::load(b+i)) : x);
+    }
+}
+
+// levels on blocks up to this size (128 KiB) run one block at a time so the
+// block stays in cache, only the larger levels pass over the whole array
+static const size_t _NTT_CHUNK = 1 << 15;
+
+// forward transform for n >= 64
+template <uint32_t P>
+__attribute__((target("avx2")))
+static void _ntt_avx2(uint32_t *a, size_t n, const _ntt_tables<P>& tb)
+{
+    size_t len = n;
+    if (__builtin_ctzll(n) % 2)
+    {
+        _radix2_avx2<P>(a,n);
+        len /= 2;
+    }
+    for (; len > _NTT_CHUNK; len /= 4)
+        _ntt_level_avx2<P>(a,0,n,len,tb);
+    for (size_t c = 0; c < n; c += len)
+    {
+        for (size_t l = len; l >= 64; l /= 4)
+            _ntt_level_avx2<P>(a,c,c+len,l,tb);
+        _ntt_last_avx2<P>(a,c,c+len,tb);
+    }
+}
+
+// inverse transform for n >= 64, without the division by n
+template <uint32_t P>
+__attribute__((target("avx2")))
+static void _intt_avx2(uint32_t *a, size_t n, const _ntt_tables<P>& tb)
+{
+    const size_t top = __builtin_ctzll(n) % 2 ? n/2 : n; // radix 4 up to top
+    size_t len = top;
+    while (len > _NTT_CHUNK)
+        len /= 4;
+    for (size_t c = 0; c < n; c += len)
+    {
+        _intt_first_avx2<P>(a,c,c+len,tb);
+        for (size_t l = 64; l <= len; l *= 4)
+            _intt_level_avx2<P>(a,c,c+len,l,tb);
+    }
+    for (len *= 4; len <= top; len *= 4)
+        _intt_level_avx2<P>(a,0,n,len,tb);
+    if (top != n)
+        _radix2_avx2<P>(a,n);
+}
+
+static bool _has_avx2()
+{
+    static const bool ret = __builtin_cpu_supports("avx2");
+    return ret;
+}
+
+// forward transform of length n = 2^j, result in bit reversed order
+template <uint32_t P>
+void ntt(ModInt<P> *a, size_t n)
+{
+    static_assert(sizeof(ModInt<P>) == sizeof(uint32_t));
+    assert((n & (n-1)) == 0);
+    if (n <= 1)
+        return;
+    _ntt_tables<P>& tb = _ntt_tables<P>::get();
+    tb.grow(n);
+    if (n >= 64 && _has_avx2())
+        _ntt_avx2<P>((uint32_t*) a,n,tb);
+    else
+        _ntt_scalar<P>(a,n,tb);
+}
+
+// inverse of ntt (bit reversed input, natural order output) including the
+// division by n
+template <uint32_t P>
+void intt(ModInt<P> *a, size_t n)
+{
+    assert((n & (n-1)) == 0);
+    if (n <= 1)
+        return;
+    _ntt_tables<P>& tb = _ntt_tables<P>::get();
+    tb.grow(n);
+    if (n >= 64 && _has_avx2())
+    {
+        _intt_avx2<P>((uint32_t*) a,n,tb);
+        const ModInt<P> inv_n = ModInt<P>((P+1)/2).pow(__builtin_ctzll(n));
+        _pointwise_avx2<P>((uint32_t*) a,nullptr,n,*(const uint32_t*) &inv_n);
+    }
+    else
+        _intt_scalar<P>(a,n,tb);
+}
+
+// product of polynomials (coefficients in increasing degree order)
+template <uint32_t P>
+std::vector<ModInt<P>> convolution(const std::vector<ModInt<P>>& a,
+    const std::vector<ModInt<P>>& b)
+{
+    typedef ModInt<P> M;
+    if (a.empty() || b.empty())
+        return {};
+    const size_t len = a.size() + b.size() - 1;
+    if (std::min(a.size(),b.size()) <= 32) // schoolbook
+    {
+        std::vector<M> ret(len);
+        for (size_t i = 0; i < a.size(); ++i)
+            for (size_t j = 0; j < b.size(); ++j)
+                ret[i+j] += a[i]*b[j];
+        return ret;
+    }
+    size_t n = 1;
+    while (n < len)
+        n *= 2;
+    std::vector<M> fa(n), fb(n);
+    std::copy(a.begin(),a.end(),fa.begin());
+    std::copy(b.begin(),b.end(),fb.begin());
+    ntt(fa.data(),n);
+    ntt(fb.data(),n);
+    if (_has_avx2()) // n >= 128 here
+    {
+        // product and division by n in one pass
+        const M inv_n = M((P+1)/2).pow(__builtin_ctzll(n));
+        _pointwise_avx2<P>((uint32_t*) fa.data(),(const uint32_t*) fb.data(),
+            n,*(const uint32_t*) &inv_n);
+        _intt_avx2<P>((uint32_t*) fa.data(),n,_ntt_tables<P>::get());
+    }
+    else
+    {
+        for (size_t i = 0; i < n; ++i)
+            fa[i] *= fb[i];
+        intt(fa.data(),n);
+    }
+    fa.resize(len);
+    return fa;
+}
+
+template <uint32_t P>
+using fps = std::vector<ModInt<P>>;
+
+// a[i] *= b[i]
+template <uint32_t P>
+static void _fps_pointwise(ModInt<P> *a, const ModInt<P> *b, size_t n)
+{
+    if (n >= 8 && _has_avx2())
+    {
+        const ModInt<P> one = 1;
+        _pointwise_avx2<P>((uint32_t*) a,(const uint32_t*) b,n,
+            *(const uint32_t*) &one);
+    }
+    else
+        for (size_t i = 0; i < n; ++i)
+            a[i] *= b[i];
+}
+
+// f mod x^n with zero padding
+template <uint32_t P>
+static fps<P> _fps_prefix(const fps<P>& f, size_t n)
+{
+    fps<P> ret(n);
+    std::copy(f.begin(),f.begin()+std::min(n,f.size()),ret.begin());
+    return ret;
+}
+
+// 1/f mod x^n, requires f[0] != 0
+template <uint32_t P>
+fps<P> fps_inv(const fps<P>& f, size_t n)
+{
+    typedef ModInt<P> M;
+    assert(!f.empty() && f[0] != 0);
+    fps<P> g = {~f[0]};
+    for (size_t m = 1; m < n; m *= 2)
+    {
+        // g = 1/f mod x^m, extend to x^2m with g - (f*g - 1)*g where f*g - 1
+        // has no terms below x^m
+        fps<P> a = _fps_prefix(f,2*m), b = _fps_prefix(g,2*m);
+        ntt(a.data(),2*m);
+        ntt(b.data(),2*m);
+        _fps_pointwise<P>(a.data(),b.data(),2*m);
+        intt(a.data(),2*m);
+        std::fill(a.begin(),a.begin()+m,M(0));
+        ntt(a.data(),2*m);
+        _fps_pointwise<P>(a.data(),b.data(),2*m);
+        intt(a.data(),2*m);
+        g.resize(2*m);
+        for (size_t i = m; i < 2*m; ++i)
+            g[i] = -a[i];
+    }
+    g.resize(n);
+    return g;
+}
+
+// subproduct tree over a fixed set of points, reusable for many evaluations
+// and interpolations
+template <uint32_t P>
+class subproduct_tree
+{
+    typedef ModInt<P> M;
+
+    // node sizes below this use quadratic loops instead of transforms
+    static constexpr size_t _SMALL = 32;
+
+    size_t _m, _n, _k; // points, padded size n = 2^k
+    // _coef[l][i*h..(i+1)*h) = low coefficients of node i on level l
+    std::vector<std::vector<M>> _coef;
+    // _tr[l][2ih..2(i+1)h) = transform of length 2h of node i (h >= _SMALL)
+    std::vector<std::vector<M>> _tr;
+
+    // out[0..h) = (g*p)[h..2h) for g of length 2h, p monic of degree h (low
+    // coefficients given)
+    static void _middle_naive(const M *g, const M *p, M *out, size_t h)
+    {
+        for (size_t i = 0; i < h; ++i)
+        {
+            M s = g[i];
+            for (size_t j = 0; j < h; ++j)
+                s += g[i+h-j] * p[j];
+            out[i] = s;
+        }
+    }
+
+public:
+    subproduct_tree(const std::vector<M>& xs): _m(xs.size()), _n(1), _k(0)
+    {
+        while (_n < _m)
+            _n *= 2, ++_k;
+        _coef.assign(_k+1,std::vector<M>(_n));
+        _tr.resize(_k+1);
+        for (size_t i = 0; i < _m; ++i)
+            _coef[0][i] = -xs[i];
+        for (size_t l = 0, h = 1; l < _k; ++l, h *= 2)
+        {
+            const std::vector<M>& c = _coef[l];
+            std::vector<M>& d = _coef[l+1];
+            for (size_t s = 0; s < _n; s += 2*h)
+            {
+                // (x^h + A)(x^h + B) = x^2h + x^h*(A + B) + A*B
+                M *out = d.data()+s;
+                if (h < _SMALL)
+                {
+                    for (size_t i = 0; i < h; ++i)
+                        for (size_t j = 0; j < h; ++j)
+                            out[i+j] += c[s+i] * c[s+h+j];
+                    for (size_t i = 0; i < h; ++i)
+                        out[h+i] += c[s+i] + c[s+h+i];
+                }
+                else
+                {
+                    // cyclic product of length 2h, x^2h wraps to 1
+                    std::copy(_tr[l].begin()+s*2,_tr[l].begin()+s*2+2*h,out);
+                    _fps_pointwise<P>(out,_tr[l].data()+s*2+2*h,2*h);
+                    intt(out,2*h);
+                    out[0] -= 1;
+                }
+            }
+            // transforms of length 4h for the next level
+            if (2*h >= _SMALL && l+1 < _k)
+            {
+                _tr[l+1].assign(2*_n,M(0));
+                for (size_t s = 0; s < _n; s += 2*h)
+                {
+                    M *t = _tr[l+1].data()+2*s;
+                    std::copy(d.begin()+s,d.begin()+s+2*h,t);
+                    t[2*h] = 1;
+                    ntt(t,4*h);
+                }
+            }
+        }
+    }
+
+    // product of (x - x_i) over the points
+    std::vector<M> poly() const
+    {
+        std::vector<M> ret(_coef[_k].begin(),_coef[_k].begin()+_m);
+        ret.push_back(1);
+        // the zero padding contributes x^(n-m)
+        std::copy(_coef[_k].begin()+(_n-_m),_coef[_k].end(),ret.begin());
+        return ret;
+    }
+
+    // f at every point
+    std::vector<M> eval(const std::vector<M>& f) const
+    {
+        if (_m == 0)
+            return {};
+        if (f.empty())
+            return std::vector<M>(_m);
+        // g_root = mulT(f,1/T_root), T_root[j] = P_root[n-j]
+        const size_t lf = f.size();
+        std::vector<M> t(_n+1);
+        t[0] = 1;
+        for (size_t j = 1; j <= _n; ++j)
+            t[j] = _coef[_k][_n-j];
+        std::vector<M> it = fps_inv(t,lf);
+        std::reverse(it.begin(),it.end());
+        const std::vector<M> mp = convolution(f,it);
+        std::vector<M> g(_n), next(_n), buf(2*_n), buf2(2*_n);
+        for (size_t i = 0; i < _n && i < lf; ++i)
+            g[i] = mp[i+lf-1];
+        for (size_t l = _k, h = _n/2; l--; h /= 2)
+        {
+            const std::vector<M>& c = _coef[l];
+            for (size_t s = 0; s < _n; s += 2*h)
+            {
+                if (h < _SMALL)
+                {
+                    _middle_naive(g.data()+s,c.data()+s+h,next.data()+s,h);
+                    _middle_naive(g.data()+s,c.data()+s,next.data()+s+h,h);
+                    continue;
+                }
+                const M *tl = _tr[l].data()+2*s, *tr = tl+2*h;
+                std::copy(g.begin()+s,g.begin()+s+2*h,buf.begin());
+                ntt(buf.data(),2*h);
+                std::copy(buf.begin(),buf.begin()+2*h,buf2.begin());
+                _fps_pointwise<P>(buf.data(),tr,2*h);
+                _fps_pointwise<P>(buf2.data(),tl,2*h);
+                intt(buf.data(),2*h);
+                intt(buf2.data(),2*h);
+                std::copy(buf.begin()+h,buf.begin()+2*h,next.begin()+s);
+                std::copy(buf2.begin()+h,buf2.begin()+2*h,next.begin()+s+h);
+            }
+            std::swap(g,next);
+        }
+        g.resize(_m);
+        return g;
+    }
+
+    // polynomial of degree < m with the values ys at the points (which must
+    // be distinct)
+    std::vector<M> interpolate(const std::vector<M>& ys) const
+    {
+        assert(ys.size() == _m);
+        if (_m == 0)
+            return {};
+        // c_i = y_i/P'(x_i)
+        std::vector<M> dp = poly();
+        for (size_t i = 1; i < dp.size(); ++i)
+            dp[i-1] = dp[i] * i;
+        dp.pop_back();
+        std::vector<M> r = eval(dp);
+        // batch inversion with prefix products
+        std::vector<M> pre(_m+1,M(1));
+        for (size_t i = 0; i < _m; ++i)
+        {
+            assert(r[i] != 0); // distinct points
+            pre[i+1] = pre[i] * r[i];
+        }
+        M inv = ~pre[_m];
+        for (size_t i = _m; i--;)
+        {
+            const M ri = r[i];
+            r[i] = inv * pre[i] * ys[i];
+            inv *= ri;
+        }
+        r.resize(_n);
+        // R_v = R_L*P_R + R_R*P_L from the leaves up
+        std::vector<M> next(_n), buf(2*_n), buf2(2*_n);
+        for (size_t l = 0, h = 1; l < _k; ++l, h *= 2)
+        {
+            const std::vector<M>& c = _coef[l];
+            for (size_t s = 0; s < _n; s += 2*h)
+            {
+                M *out = next.data()+s;
+                const M *rl = r.data()+s, *rr = rl+h;
+                if (h < _SMALL)
+                {
+                    // x^h*(R_L + R_R) + R_L*B + R_R*A
+                    std::fill(out,out+2*h,M(0));
+                    for (size_t i = 0; i < h; ++i)
+                    {
+                        out[h+i] = rl[i] + rr[i];
+                        for (size_t j = 0; j < h; ++j)
+                            out[i+j] += rl[i]*c[s+h+j] + rr[i]*c[s+j];
+                    }
+                    continue;
+                }
+                // degree < 2h so the cyclic product of length 2h is exact
+                const M *tl = _tr[l].data()+2*s, *tr = tl+2*h;
+                std::fill(buf.begin(),buf.begin()+2*h,M(0));
+                std::fill(buf2.begin(),buf2.begin()+2*h,M(0));
+                std::copy(rl,rl+h,buf.begin());
+                std::copy(rr,rr+h,buf2.begin());
+                ntt(buf.data(),2*h);
+                ntt(buf2.data(),2*h);
+                _fps_pointwise<P>(buf.data(),tr,2*h);
+                _fps_pointwise<P>(buf2.data(),tl,2*h);
+                for (size_t i = 0; i < 2*h; ++i)
+                    buf[i] += buf2[i];
+                intt(buf.data(),2*h);
+                std::copy(buf.begin(),buf.begin()+2*h,out);
+            }
+            std::swap(r,next);
+        }
+        return std::vector<M>(r.begin()+(_n-_m),r.end());
+    }
+};
+
+// f at each point of xs
+template <uint32_t P>
+std::vector<ModInt<P>> multipoint_eval(const std::vector<ModInt<P>>& f,
+    const std::vector<ModInt<P>>& xs)
+{
+    return subproduct_tree<P>(xs).eval(f);
+}
+
+// polynomial of degree < n through the points (xs[i],ys[i]), xs distinct
+template <uint32_t P>
+std::vector<ModInt<P>> interpolate(const std::vector<ModInt<P>>& xs,
+    const std::vector<ModInt<P>>& ys)
+{
+    return subproduct_tree<P>(xs).interpolate(ys);
+}
+
+// horner evaluation for testing
+template <uint32_t P>
+static ModInt<P> _horner(const std::vector<ModInt<P>>& f, ModInt<P> x)
+{
+    ModInt<P> v = 0;
+    for (size_t i = f.size(); i--;)
+        v = v*x + f[i];
+    return v;
+}
+
+int main(int argc, char **argv)
+{
+    const uint32_t P = 998244353;
+    typedef ModInt<P> M;
+    std::mt19937_64 rng(18);
+    assert(multipoint_eval<P>({1,2,3},{}).empty());
+    assert(multipoint_eval<P>({},{5,6}) == std::vector<M>(2));
+    assert(multipoint_eval<P>({1,2,3},{0,1,2,-1})
+        == std::vector<M>({1,6,17,2}));
+    assert(interpolate<P>({0,1,2},{1,6,17}) == std::vector<M>({1,2,3}));
+    assert(interpolate<P>({4},{9}) == std::vector<M>({9}));
+    assert(subproduct_tree<P>({1,2}).poly() == std::vector<M>({2,-3,1}));
+    for (size_t m : {1,2,3,5,31,32,33,64,100,257,1000})
+        for (size_t lf : {(size_t) 0,(size_t) 1,(size_t) 7,(size_t) 100,m,3*m})
+        {
+            std::vector<M> xs(m), f(lf);
+            for (M& x : xs)
+                x = rng();
+            if (m > 3)
+                xs[1] = 0, xs[2] = xs[3]; // repeated points in evaluation
+            for (M& x : f)
+                x = rng();
+            const std::vector<M> v = multipoint_eval(f,xs);
+            for (size_t i = 0; i < m; ++i)
+                assert(v[i] == _horner(f,xs[i]));
+        }
+    for (size_t m : {1,2,3,5,31,32,33,64,100,257,1000})
+    {
+        std::vector<M> xs(m), f(m);
+        for (size_t i = 0; i < m; ++i)
+            xs[i] = rng() % 2 ? M(rng()) : M(i);
+        std::sort(xs.begin(),xs.end());
+        xs.erase(std::unique(xs.begin(),xs.end()),xs.end());
+        f.resize(xs.size());
+        for (M& x : f)
+            x = rng();
+        const subproduct_tree<P> tree(xs);
+        assert(tree.interpolate(tree.eval(f)) == f);
+    }
+
+    // run with "bench" argument for timing
+    if (argc > 1 && std::string(argv[1]) == "bench")
+    {
+        auto ms = [](auto s, auto t)
+        { return std::chrono::duration<double,std::milli>(t-s).count(); };
+        for (size_t n : {1 << 12, 1 << 15, 1 << 17})
+        {
+            // distinct points for interpolation
+            std::vector<M> xs(n), f(n);
+            const M c = rng() % (P-1) + 1, d = rng();
+            for (size_t i = 0; i < n; ++i)
+                xs[i] = c*i + d, f[i] = rng();
+            auto t0 = std::chrono::steady_clock::now();
+            const subproduct_tree<P> tree(xs);
+            auto t1 = std::chrono::steady_clock::now();
+            const std::vector<M> v = tree.eval(f);
+            auto t2 = std::chrono::steady_clock::now();
+            const std::vector<M> g = tree.interpolate(v);
+            auto t3 = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < n; i += n/16)
+                assert(v[i] == _horner(f,xs[i]));
+            assert(g == f);
+            printf("n = %zu: tree %.1f ms, evaluation %.1f ms, "
+                "interpolation %.1f ms\n",n,ms(t0,t1),ms(t1,t2),ms(t2,t3));
+        }
+        // horner at every point for comparison
+        const size_t n = 1 << 14;
+        std::vector<M> xs(n), f(n), v(n);
+        for (size_t i = 0; i < n; ++i)
+            xs[i] = rng(), f[i] = rng();
+        auto t0 = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < n; ++i)
+            v[i] = _horner(f,xs[i]);
+        auto t1 = std::chrono::steady_clock::now();
+        assert(v == multipoint_eval(f,xs));
+        printf("n = %zu: horner evaluation %.1f ms\n",n,ms(t0,t1));
+    }
+}
@@ -0,0 +1,1260 @@
+/*
+Number theoretic transform (NTT) and convolution modulo NTT friendly primes
+
+For a prime P = c*2^k+1 (998244353 = 119*2^23+1 by default) the transform of
+length n = 2^j <= 2^k evaluates a polynomial at the n-th roots of unity, so
+convolution (polynomial multiplication) is 2 forward transforms, a pointwise
+product and an inverse transform in O(n log n), instead of the O(n*m) loop of
+RatPoly.__mul__ in py/exact_math/ratpoly.py.
+
+The forward transform splits a mod (x^2m - w^2) into a mod (x^m - w) and
+a mod (x^m + w) (butterfly u,v -> u+w*v, u-w*v) from the whole array down to
+single elements. It takes natural order input and leaves the result in bit
+reversed order, and the inverse undoes the butterflies in reverse (bit reversed
+input, natural output), so no bit reversal permutation is needed for
+convolution. Block k of every level uses the same twiddle w[k] = the
+2^(j+2)-th root of unity to the power bitrev_(j+1)(k) for k in [2^j,2^(j+1)),
+which is independent of n, so one table (grown on demand) serves every length.
+
+Two levels are merged into a radix 4 butterfly. With w1 = w[2k] (w[k] = w1^2
+and w[2k+1] = i*w1 where i is a 4th root of unity):
+  b1 = w1*a1, b2 = w1^2*a2, b3 = w1^3*a3
+  a0 + b2 + (b1 + b3), a0 + b2 - (b1 + b3),
+  a0 - b2 + i*(b1 - b3), a0 - b2 - i*(b1 - b3)
+A radix 2 level handles odd log2(n). Values are ModInt<P> (montgomery form,
+copied from cpp/modint/modint.cpp).
+
+With AVX2 (checked at runtime, scalar code otherwise) 8 butterflies run at
+once, and 16 with AVX-512. Levels with blocks of 16 or 4 elements work inside
+registers with per-lane twiddles (with AVX-512 both levels at once on 64
+elements transposed so the butterflies are between registers), and the large
+levels run over chunks of 2^15 elements so they stay in cache. convolution
+finishes both forward transforms, the pointwise product (with the 1/n of the
+inverse) and the first inverse levels one chunk at a time.
+
+On one 2 GHz core with AVX-512, a transform of length 2^21 takes about 7 ms
+and a convolution of two length 2^20 inputs about 30 ms (12.5 ms and 45 ms
+with AVX2 only), of which about 8 ms are page faults of the two new arrays.
+The transforms run at about 0.6 cycles per element per radix 4 level,
+bounded by the vector multiplies (6 per montgomery product), so the few
+milliseconds of a faster many core machine is not reached here.
+*/
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <ostream>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <immintrin.h>
+
+template <uint32_t P>
+class ModInt
+{
+    static_assert(P % 2 == 1 && P < (1u << 31),"P must be odd and below 2^31");
+
+    // -P^-1 mod 2^32 by newton iteration (each step doubles the correct bits)
+    static constexpr uint32_t _neg_inv()
+    {
+        uint32_t inv = P;
+        for (int i = 0; i < 4; ++i)
+            inv *= 2 - P*inv;
+        return -inv;
+    }
+
+    static constexpr uint32_t _NINV = _neg_inv();
+    static constexpr uint32_t _R2 = (uint32_t) (((__uint128_t) 1 << 64) % P);
+    uint32_t _v; // montgomery form, in [0,P)
+
+    // t*R^-1 mod P for t < P*2^32
+    static constexpr uint32_t _reduce(uint64_t t)
+    {
+        const uint32_t m = (uint32_t) t * _NINV;
+        const uint32_t r = (t + (uint64_t) m*P) >> 32; // < 2P
+        return r >= P ? r - P : r;
+    }
+
+    // integer to [0,P) including negative values
+    template <typename I>
+    static constexpr uint32_t _mod(I x)
+    {
+        static_assert(std::is_integral_v<I>);
+        if constexpr (std::is_signed_v<I>)
+        {
+            const int64_t r = (int64_t) x % (int64_t) P;
+            return r < 0 ? r + P : r;
+        }
+        else
+            return (uint64_t) x % P;
+    }
+
+    // value from montgomery form without conversion
+    static constexpr ModInt _raw(uint32_t v)
+    {
+        ModInt ret;
+        ret._v = v;
+        return ret;
+    }
+
+public:
+    constexpr ModInt(): _v(0) {}
+    template <typename I, typename = std::enable_if_t<std::is_integral_v<I>>>
+    constexpr ModInt(I x): _v(_reduce((uint64_t) _mod(x)*_R2)) {}
+
+    static constexpr uint32_t mod() { return P; }
+    // value in [0,P)
+    constexpr uint32_t val() const { return _reduce(_v); }
+    explicit constexpr operator uint32_t() const { return val(); }
+    explicit constexpr operator bool() const { return _v != 0; }
+
+    // arithmetic
+    constexpr ModInt& operator+=(const ModInt& o)
+    {
+        const uint32_t r = _v + o._v - P; // wraps below 0 when _v+o._v < P
+        _v = r + (-(r >> 31) & P);
+        return *this;
+    }
+    constexpr ModInt& operator-=(const ModInt& o)
+    {
+        const uint32_t r = _v - o._v;
+        _v = r + (-(r >> 31) & P);
+        return *this;
+    }
+    constexpr ModInt& operator*=(const ModInt& o)
+    {
+        _v = _reduce((uint64_t) _v*o._v);
+        return *this;
+    }
+    constexpr ModInt& operator/=(const ModInt& o) { return *this *= ~o; }
+
+    friend constexpr ModInt operator+(ModInt a, const ModInt& b)
+    { return a += b; }
+    friend constexpr ModInt operator-(ModInt a, const ModInt& b)
+    { return a -= b; }
+    friend constexpr ModInt operator*(ModInt a, const ModInt& b)
+    { return a *= b; }
+    friend constexpr ModInt operator/(ModInt a, const ModInt& b)
+    { return a /= b; }
+
+    constexpr ModInt operator+() const { return *this; }
+    constexpr ModInt operator-() const { return ModInt() - *this; }
+
+    // inverse with the extended euclidean algorithm (P may be composite)
+    constexpr ModInt operator~() const
+    {
+        assert(P > 1 && _v != 0); // 0 has no inverse
+        int64_t r0 = val(), r1 = P, s0 = 1, s1 = 0;
+        while (r1)
+        {
+            const int64_t q = r0/r1;
+            r0 -= q*r1;
+            s0 -= q*s1;
+            std::swap(r0,r1);
+            std::swap(s0,s1);
+        }
+        assert(r0 == 1); // not invertible
+        return ModInt(s0);
+    }
+
+    // power, negative exponents use the inverse
+    constexpr ModInt pow(int64_t e) const
+    {
+        ModInt b = e < 0 ? ~*this : *this, ret = _raw(_reduce(_R2));
+        uint64_t k = e < 0 ? -(uint64_t) e : e;
+        for (; k; k >>= 1, b *= b)
+            if (k & 1)
+                ret *= b;
+        return P == 1 ? ModInt() : ret;
+    }
+
+    // comparisons by value (montgomery form is a bijection so == is direct)
+    friend constexpr bool operator==(const ModInt& a, const ModInt& b)
+    { return a._v == b._v; }
+    friend constexpr bool operator!=(const ModInt& a, const ModInt& b)
+    { return a._v != b._v; }
+    friend constexpr bool operator<(const ModInt& a, const ModInt& b)
+    { return a.val() < b.val(); }
+    friend constexpr bool operator<=(const ModInt& a, const ModInt& b)
+    { return a.val() <= b.val(); }
+    friend constexpr bool operator>(const ModInt& a, const ModInt& b)
+    { return a.val() > b.val(); }
+    friend constexpr bool operator>=(const ModInt& a, const ModInt& b)
+    { return a.val() >= b.val(); }
+
+    friend std::ostream& operator<<(std::ostream& os, const ModInt& a)
+    { return os << a.val(); }
+};
+
+// smallest primitive root of a prime P
+template <uint32_t P>
+constexpr uint32_t _primitive_root()
+{
+    uint32_t f[32], nf = 0, m = P-1;
+    for (uint32_t d = 2; (uint64_t) d*d <= m; ++d)
+        if (m % d == 0)
+        {
+            f[nf++] = d;
+            while (m % d == 0)
+                m /= d;
+        }
+    if (m > 1)
+        f[nf++] = m;
+    for (uint32_t g = 2;; ++g)
+    {
+        bool ok = true;
+        for (uint32_t i = 0; i < nf && ok; ++i)
+            ok = ModInt<P>(g).pow((P-1)/f[i]) != 1;
+        if (ok)
+            return g;
+    }
+}
+
+// twiddle tables for the transforms modulo P
+template <uint32_t P>
+class _ntt_tables
+{
+    typedef ModInt<P> M;
+
+public:
+    static constexpr uint32_t G = _primitive_root<P>();
+    static constexpr uint32_t K = __builtin_ctz(P-1); // max length 2^K
+    // w[k] (see above), its inverse, and w[k]*w[2k] with inverse for radix 4
+    std::vector<M> w, iw, w3, iw3;
+    // per lane twiddles of the last radix 4 level (block size 4) for the
+    // vector code, t1[4k..4k+3] = 1,w[2k],w[k],w3[k] (inverses in it1)
+    std::vector<M> t1, it1;
+    M imag, iimag; // 4th root of unity i and i^-1
+
+    _ntt_tables(): w(1,1), iw(1,1), w3(1,1), iw3(1,1)
+    {
+        static_assert(K >= 2);
+        imag = M(G).pow((P-1)/4);
+        iimag = ~imag;
+    }
+
+    // tables for transforms of length n
+    void grow(size_t n)
+    {
+        assert(n <= ((size_t) 1 << K));
+        const size_t old = w.size();
+        if (n/2 <= old)
+            return;
+        w.resize(n/2);
+        iw.resize(n/2);
+        // w[2^j + t] = w[t] * (primitive 2^(j+2)-th root)
+        for (size_t h = old; h < n/2; h *= 2)
+        {
+            const uint32_t j = __builtin_ctzll(h);
+            const M r = M(G).pow((P-1) >> (j+2)), ir = ~r;
+            for (size_t t = 0; t < h; ++t)
+            {
+                w[h+t] = w[t]*r;
+                iw[h+t] = iw[t]*ir;
+            }
+        }
+        // radix 4 blocks use indices k < n/4
+        w3.resize(n/4);
+        iw3.resize(n/4);
+        t1.resize(n);
+        it1.resize(n);
+        for (size_t k = 0; k < n/4; ++k)
+        {
+            w3[k] = w[k]*w[2*k];
+            iw3[k] = iw[k]*iw[2*k];
+            t1[4*k] = it1[4*k] = 1;
+            t1[4*k+1] = w[2*k];
+            t1[4*k+2] = w[k];
+            t1[4*k+3] = w3[k];
+            it1[4*k+1] = iw[2*k];
+            it1[4*k+2] = iw[k];
+            it1[4*k+3] = iw3[k];
+        }
+    }
+
+    static _ntt_tables& get()
+    {
+        static _ntt_tables tables;
+        return tables;
+    }
+};
+
+template <uint32_t P>
+static void _ntt_scalar(ModInt<P> *a, size_t n, const _ntt_tables<P>& tb)
+{
+    typedef ModInt<P> M;
+    const M *w = tb.w.data(), *w3 = tb.w3.data();
+    const M imag = tb.imag;
+    size_t len = n; // block size
+    if (__builtin_ctzll(n) % 2) // radix 2 level with w[0] = 1
+    {
+        for (size_t j = 0; j < n/2; ++j)
+        {
+            const M u = a[j], v = a[j+n/2];
+            a[j] = u+v;
+            a[j+n/2] = u-v;
+        }
+        len /= 2;
+    }
+    for (; len >= 4; len /= 4)
+    {
+        const size_t m = len/4;
+        for (size_t s = 0, k = 0; s < n; s += len, ++k)
+        {
+            const M w1 = w[2*k], w2 = w[k], ww3 = w3[k];
+            M *b = a+s;
+            for (size_t j = 0; j < m; ++j)
+            {
+                const M a0 = b[j], b1 = b[j+m]*w1, b2 = b[j+2*m]*w2,
+                    b3 = b[j+3*m]*ww3;
+                const M x = a0+b2, y = a0-b2, z = b1+b3, t = (b1-b3)*imag;
+                b[j] = x+z;
+                b[j+m] = x-z;
+                b[j+2*m] = y+t;
+                b[j+3*m] = y-t;
+            }
+        }
+    }
+}
+
+template <uint32_t P>
+static void _intt_scalar(ModInt<P> *a, size_t n, const _ntt_tables<P>& tb)
+{
+    typedef ModInt<P> M;
+    const M *iw = tb.iw.data(), *iw3 = tb.iw3.data();
+    const M iimag = tb.iimag;
+    const size_t top = __builtin_ctzll(n) % 2 ? n/2 : n; // radix 4 up to top
+    for (size_t len = 4; len <= top; len *= 4)
+    {
+        const size_t m = len/4;
+        for (size_t s = 0, k = 0; s < n; s += len, ++k)
+        {
+            const M iw1 = iw[2*k], iw2 = iw[k], iww3 = iw3[k];
+            M *b = a+s;
+            for (size_t j = 0; j < m; ++j)
+            {
+                const M c0 = b[j], c1 = b[j+m], c2 = b[j+2*m], c3 = b[j+3*m];
+                // x = 2(a0+b2), y = 2(a0-b2), z = 2(b1+b3), t = 2(b1-b3)
+                const M x = c0+c1, z = c0-c1, y = c2+c3, t = (c2-c3)*iimag;
+                b[j] = x+y;
+                b[j+m] = (z+t)*iw1;
+                b[j+2*m] = (x-y)*iw2;
+                b[j+3*m] = (z-t)*iww3;
+            }
+        }
+    }
+    if (top != n)
+        for (size_t j = 0; j < n/2; ++j)
+        {
+            const M u = a[j], v = a[j+n/2];
+            a[j] = u+v;
+            a[j+n/2] = u-v;
+        }
+    const M inv_n = M((P+1)/2).pow(__builtin_ctzll(n));
+    for (size_t i = 0; i < n; ++i)
+        a[i] *= inv_n;
+}
+
+// AVX2 on 8 lanes of montgomery values (as in cpp/modint/modint_simd.cpp)
+
+template <uint32_t P>
+struct _avx2_mod
+{
+    // P^-1 mod 2^32
+    static constexpr uint32_t _inv()
+    {
+        uint32_t inv = P;
+        for (int i = 0; i < 4; ++i)
+            inv *= 2 - P*inv;
+        return inv;
+    }
+
+    __attribute__((target("avx2")))
+    static __m256i add(__m256i a, __m256i b)
+    {
+        const __m256i s = _mm256_add_epi32(a,b);
+        return _mm256_min_epu32(s,_mm256_sub_epi32(s,_mm256_set1_epi32(P)));
+    }
+
+    __attribute__((target("avx2")))
+    static __m256i sub(__m256i a, __m256i b)
+    {
+        const __m256i d = _mm256_sub_epi32(a,b);
+        return _mm256_min_epu32(d,_mm256_add_epi32(d,_mm256_set1_epi32(P)));
+    }
+
+    __attribute__((target("avx2")))
+    static __m256i mul(__m256i a, __m256i b)
+    {
+        const __m256i p = _mm256_set1_epi32(P);
+        const __m256i pinv = _mm256_set1_epi32(_inv());
+        const __m256i te = _mm256_mul_epu32(a,b);
+        const __m256i to = _mm256_mul_epu32(_mm256_srli_epi64(a,32),
+            _mm256_srli_epi64(b,32));
+        const __m256i ue = _mm256_mul_epu32(_mm256_mul_epu32(te,pinv),p);
+        const __m256i uo = _mm256_mul_epu32(_mm256_mul_epu32(to,pinv),p);
+        const __m256i re = _mm256_srli_epi64(_mm256_sub_epi64(te,ue),32);
+        const __m256i ro = _mm256_sub_epi64(to,uo);
+        const __m256i r = _mm256_blend_epi32(re,ro,0xaa);
+        return _mm256_min_epu32(r,_mm256_add_epi32(r,p));
+    }
+
+    // a*w for a broadcast w with wp = w*P^-1 mod 2^32 (also broadcast), so
+    // the quotients q = a*wp do not wait on the product a*w
+    __attribute__((target("avx2")))
+    static __m256i mul_const(__m256i a, __m256i w, __m256i wp)
+    {
+        const __m256i p = _mm256_set1_epi32(P);
+        const __m256i ao = _mm256_srli_epi64(a,32);
+        const __m256i te = _mm256_mul_epu32(a,w), to = _mm256_mul_epu32(ao,w);
+        const __m256i ue = _mm256_mul_epu32(_mm256_mul_epu32(a,wp),p);
+        const __m256i uo = _mm256_mul_epu32(_mm256_mul_epu32(ao,wp),p);
+        const __m256i re = _mm256_srli_epi64(_mm256_sub_epi64(te,ue),32);
+        const __m256i ro = _mm256_sub_epi64(to,uo);
+        const __m256i r = _mm256_blend_epi32(re,ro,0xaa);
+        return _mm256_min_epu32(r,_mm256_add_epi32(r,p));
+    }
+
+    // broadcast w and w*P^-1 for mul_const
+    struct cw { __m256i w, wp; };
+    __attribute__((target("avx2")))
+    static cw bconst(uint32_t w)
+    {
+        return {_mm256_set1_epi32(w),_mm256_set1_epi32(w*_inv())};
+    }
+
+    __attribute__((target("avx2")))
+    static __m256i load(const uint32_t *p)
+    {
+        return _mm256_loadu_si256((const __m256i*) p);
+    }
+
+    __attribute__((target("avx2")))
+    static void store(uint32_t *p, __m256i v)
+    {
+        _mm256_storeu_si256((__m256i*) p,v);
+    }
+
+    // lanes 0-3 from a and lanes 4-7 from b
+    __attribute__((target("avx2")))
+    static __m256i halves(uint32_t a, uint32_t b)
+    {
+        return _mm256_setr_epi32(a,a,a,a,b,b,b,b);
+    }
+};
+
+// AVX-512 on 16 lanes with the same operations (the masked zeroing forms of
+// the intrinsics avoid false uninitialized warnings from the gcc 12 headers,
+// as in cpp/modint/modint_simd.cpp)
+template <uint32_t P>
+struct _avx512_mod
+{
+    __attribute__((target("avx512f")))
+    static __m512i _mul32(__m512i a, __m512i b)
+    {
+        return _mm512_maskz_mul_epu32(0xff,a,b);
+    }
+
+    __attribute__((target("avx512f")))
+    static __m512i _hi(__m512i a)
+    {
+        return _mm512_maskz_srli_epi64(0xff,a,32);
+    }
+
+    __attribute__((target("avx512f")))
+    static __m512i add(__m512i a, __m512i b)
+    {
+        const __m512i s = _mm512_add_epi32(a,b);
+        return _mm512_maskz_min_epu32(0xffff,s,
+            _mm512_sub_epi32(s,_mm512_set1_epi32(P)));
+    }
+
+    __attribute__((target("avx512f")))
+    static __m512i sub(__m512i a, __m512i b)
+    {
+        const __m512i d = _mm512_sub_epi32(a,b);
+        return _mm512_maskz_min_epu32(0xffff,d,
+            _mm512_add_epi32(d,_mm512_set1_epi32(P)));
+    }
+
+    // te,to are the even and odd 64 bit products, qe,qo their low halves
+    // times P^-1
+    __attribute__((target("avx512f")))
+    static __m512i _reduce(__m512i te, __m512i to, __m512i qe, __m512i qo)
+    {
+        const __m512i p = _mm512_set1_epi32(P);
+        const __m512i re = _hi(_mm512_sub_epi64(te,_mul32(qe,p)));
+        const __m512i ro = _mm512_sub_epi64(to,_mul32(qo,p));
+        const __m512i r = _mm512_mask_blend_epi32(0xaaaa,re,ro);
+        return _mm512_maskz_min_epu32(0xffff,r,_mm512_add_epi32(r,p));
+    }
+
+    __attribute__((target("avx512f")))
+    static __m512i mul(__m512i a, __m512i b)
+    {
+        const __m512i pinv = _mm512_set1_epi32(_avx2_mod<P>::_inv());
+        const __m512i te = _mul32(a,b), to = _mul32(_hi(a),_hi(b));
+        return _reduce(te,to,_mul32(te,pinv),_mul32(to,pinv));
+    }
+
+    // a*w for a broadcast w with wp = w*P^-1 mod 2^32 as in _avx2_mod
+    __attribute__((target("avx512f")))
+    static __m512i mul_const(__m512i a, __m512i w, __m512i wp)
+    {
+        const __m512i ao = _hi(a);
+        return _reduce(_mul32(a,w),_mul32(ao,w),_mul32(a,wp),_mul32(ao,wp));
+    }
+
+    struct cw { __m512i w, wp; };
+    __attribute__((target("avx512f")))
+    static cw bconst(uint32_t w)
+    {
+        return {_mm512_set1_epi32(w),
+            _mm512_set1_epi32(w*_avx2_mod<P>::_inv())};
+    }
+
+    // radix 4 butterflies (forward and inverse) with per lane twiddles and
+    // the 4th root of unity i (or i^-1) as vi,vip
+    __attribute__((target("avx512f")))
+    static void fwd4(__m512i& a0, __m512i& a1, __m512i& a2, __m512i& a3,
+        __m512i w1, __m512i w2, __m512i w3, __m512i vi, __m512i vip)
+    {
+        const __m512i b1 = mul(a1,w1), b2 = mul(a2,w2), b3 = mul(a3,w3);
+        const __m512i x = add(a0,b2), y = sub(a0,b2), z = add(b1,b3);
+        const __m512i t = mul_const(sub(b1,b3),vi,vip);
+        a0 = add(x,z);
+        a1 = sub(x,z);
+        a2 = add(y,t);
+        a3 = sub(y,t);
+    }
+
+    __attribute__((target("avx512f")))
+    static void inv4(__m512i& c0, __m512i& c1, __m512i& c2, __m512i& c3,
+        __m512i iw1, __m512i iw2, __m512i iw3, __m512i vi, __m512i vip)
+    {
+        const __m512i x = add(c0,c1), z = sub(c0,c1), y = add(c2,c3);
+        const __m512i t = mul_const(sub(c2,c3),vi,vip);
+        c0 = add(x,y);
+        c1 = mul(add(z,t),iw1);
+        c2 = mul(sub(x,y),iw2);
+        c3 = mul(sub(z,t),iw3);
+    }
+
+    __attribute__((target("avx512f")))
+    static __m512i load(const uint32_t *p)
+    {
+        return _mm512_loadu_si512(p);
+    }
+
+    __attribute__((target("avx512f")))
+    static void store(uint32_t *p, __m512i v)
+    {
+        _mm512_storeu_si512(p,v);
+    }
+};
+
+static bool _has_avx512()
+{
+    static const bool ret = __builtin_cpu_supports("avx512f");
+    return ret;
+}
+
+// radix 2 level on the halves of a (w = 1), used by both directions
+template <uint32_t P>
+__attribute__((target("avx512f")))
+static void _radix2_avx512(uint32_t *a, size_t n)
+{
+    typedef _avx512_mod<P> V;
+    for (size_t j = 0; j < n/2; j += 16)
+    {
+        const __m512i u = V::load(a+j), v = V::load(a+j+n/2);
+        V::store(a+j,V::add(u,v));
+        V::store(a+j+n/2,V::sub(u,v));
+    }
+}
+
+template <uint32_t P>
+__attribute__((target("avx2")))
+static void _radix2_avx2(uint32_t *a, size_t n)
+{
+    typedef _avx2_mod<P> V;
+    for (size_t j = 0; j < n/2; j += 8)
+    {
+        const __m256i u = V::load(a+j), v = V::load(a+j+n/2);
+        V::store(a+j,V::add(u,v));
+        V::store(a+j+n/2,V::sub(u,v));
+    }
+}
+
+// forward radix 4 level with block size len >= 64 on blocks in [lo,hi)
+template <uint32_t P>
+__attribute__((target("avx2")))
+static void _ntt_level_avx2(uint32_t *a, size_t lo, size_t hi, size_t len,
+    const _ntt_tables<P>& tb)
+{
+    typedef _avx2_mod<P> V;
+    const uint32_t *w = (const uint32_t*) tb.w.data();
+    const uint32_t *w3 = (const uint32_t*) tb.w3.data();
+    const auto [vi,vip] = V::bconst(*(const uint32_t*) &tb.imag);
+    const size_t m = len/4;
+    for (size_t s = lo, k = lo/len; s < hi; s += len, ++k)
+    {
+        const auto [w1,w1p] = V::bconst(w[2*k]);
+        const auto [w2,w2p] = V::bconst(w[k]);
+        const auto [ww3,ww3p] = V::bconst(w3[k]);
+        uint32_t *b = a+s;
+        for (size_t j = 0; j < m; j += 8)
+        {
+            const __m256i a0 = V::load(b+j);
+            const __m256i b1 = V::mul_const(V::load(b+j+m),w1,w1p);
+            const __m256i b2 = V::mul_const(V::load(b+j+2*m),w2,w2p);
+            const __m256i b3 = V::mul_const(V::load(b+j+3*m),ww3,ww3p);
+            const __m256i x = V::add(a0,b2), y = V::sub(a0,b2);
+            const __m256i z = V::add(b1,b3);
+            const __m256i t = V::mul_const(V::sub(b1,b3),vi,vip);
+            V::store(b+j,V::add(x,z));
+            V::store(b+j+m,V::sub(x,z));
+            V::store(b+j+2*m,V::add(y,t));
+            V::store(b+j+3*m,V::sub(y,t));
+        }
+    }
+}
+
+template <uint32_t P>
+__attribute__((target("avx512f")))
+static void _ntt_level_avx512(uint32_t *a, size_t lo, size_t hi, size_t len,
+    const _ntt_tables<P>& tb)
+{
+    typedef _avx512_mod<P> V;
+    const uint32_t *w = (const uint32_t*) tb.w.data();
+    const uint32_t *w3 = (const uint32_t*) tb.w3.data();
+    const auto [vi,vip] = V::bconst(*(const uint32_t*) &tb.imag);
+    const size_t m = len/4;
+    for (size_t s = lo, k = lo/len; s < hi; s += len, ++k)
+    {
+        const auto [w1,w1p] = V::bconst(w[2*k]);
+        const auto [w2,w2p] = V::bconst(w[k]);
+        const auto [ww3,ww3p] = V::bconst(w3[k]);
+        uint32_t *b = a+s;
+        for (size_t j = 0; j < m; j += 16)
+        {
+            const __m512i a0 = V::load(b+j);
+            const __m512i b1 = V::mul_const(V::load(b+j+m),w1,w1p);
+            const __m512i b2 = V::mul_const(V::load(b+j+2*m),w2,w2p);
+            const __m512i b3 = V::mul_const(V::load(b+j+3*m),ww3,ww3p);
+            const __m512i x = V::add(a0,b2), y = V::sub(a0,b2);
+            const __m512i z = V::add(b1,b3);
+            const __m512i t = V::mul_const(V::sub(b1,b3),vi,vip);
+            V::store(b+j,V::add(x,z));
+            V::store(b+j+m,V::sub(x,z));
+            V::store(b+j+2*m,V::add(y,t));
+            V::store(b+j+3*m,V::sub(y,t));
+        }
+    }
+}
+
+// forward radix 4 levels with block sizes 16 and 4 on [lo,hi), done within
+// registers with per lane twiddles
+template <uint32_t P>
+__attribute__((target("avx2")))
+static void _ntt_last_avx2(uint32_t *a, size_t lo, size_t hi,
+    const _ntt_tables<P>& tb)
+{
+    typedef _avx2_mod<P> V;
+    const uint32_t *w = (const uint32_t*) tb.w.data();
+    const uint32_t *w3 = (const uint32_t*) tb.w3.data();
+    const uint32_t *t1 = (const uint32_t*) tb.t1.data();
+    const uint32_t one = w[0], imag = *(const uint32_t*) &tb.imag;
+    // blocks of 16 as 2 registers [a0|a1], [a2|a3] of 4 lane quarters
+    const __m256i one_imag = V::halves(one,imag);
+    for (size_t s = lo, k = lo/16; s < hi; s += 16, ++k)
+    {
+        const __m256i l = V::mul(V::load(a+s),V::halves(one,w[2*k]));
+        const __m256i h = V::mul(V::load(a+s+8),V::halves(w[k],w3[k]));
+        const __m256i xz = V::add(l,h); // [x|z]
+        const __m256i yt = V::mul(V::sub(l,h),one_imag); // [y|t]
+        const __m256i zx = _mm256_permute2x128_si256(xz,xz,1);
+        const __m256i ty = _mm256_permute2x128_si256(yt,yt,1);
+        V::store(a+s,_mm256_blend_epi32(V::add(xz,zx),V::sub(zx,xz),0xf0));
+        V::store(a+s+8,_mm256_blend_epi32(V::add(yt,ty),V::sub(ty,yt),0xf0));
+    }
+    // blocks of 4, 2 per register
+    const __m256i imag3 = _mm256_setr_epi32(one,one,one,imag,one,one,one,imag);
+    for (size_t s = lo; s < hi; s += 8)
+    {
+        const __m256i b = V::mul(V::load(a+s),V::load(t1+s)); // a0 b1 b2 b3
+        const __m256i c = _mm256_shuffle_epi32(b,0x4e); // b2 b3 a0 b1
+        // x z y t
+        const __m256i d = V::mul(_mm256_blend_epi32(V::add(b,c),V::sub(c,b),
+            0xcc),imag3);
+        const __m256i e = _mm256_shuffle_epi32(d,0xb1); // z x t y
+        V::store(a+s,_mm256_blend_epi32(V::add(d,e),V::sub(e,d),0xaa));
+    }
+}
+
+// 4x4 transposes of the 128 bit quarters of a0..a3 and of the 32 bit lanes
+// within each quarter (both are their own inverse)
+__attribute__((target("avx512f")))
+static void _transpose128(__m512i& a0, __m512i& a1, __m512i& a2, __m512i& a3)
+{
+    const __m512i t0 = _mm512_maskz_shuffle_i32x4(0xffff,a0,a1,0x44);
+    const __m512i t1 = _mm512_maskz_shuffle_i32x4(0xffff,a0,a1,0xee);
+    const __m512i t2 = _mm512_maskz_shuffle_i32x4(0xffff,a2,a3,0x44);
+    const __m512i t3 = _mm512_maskz_shuffle_i32x4(0xffff,a2,a3,0xee);
+    a0 = _mm512_maskz_shuffle_i32x4(0xffff,t0,t2,0x88);
+    a1 = _mm512_maskz_shuffle_i32x4(0xffff,t0,t2,0xdd);
+    a2 = _mm512_maskz_shuffle_i32x4(0xffff,t1,t3,0x88);
+    a3 = _mm512_maskz_shuffle_i32x4(0xffff,t1,t3,0xdd);
+}
+
+__attribute__((target("avx512f")))
+static void _transpose32(__m512i& a0, __m512i& a1, __m512i& a2, __m512i& a3)
+{
+    const __m512i t0 = _mm512_maskz_unpacklo_epi32(0xffff,a0,a1);
+    const __m512i t1 = _mm512_maskz_unpackhi_epi32(0xffff,a0,a1);
+    const __m512i t2 = _mm512_maskz_unpacklo_epi32(0xffff,a2,a3);
+    const __m512i t3 = _mm512_maskz_unpackhi_epi32(0xffff,a2,a3);
+    a0 = _mm512_maskz_unpacklo_epi64(0xff,t0,t2);
+    a1 = _mm512_maskz_unpackhi_epi64(0xff,t0,t2);
+    a2 = _mm512_maskz_unpacklo_epi64(0xff,t1,t3);
+    a3 = _mm512_maskz_unpackhi_epi64(0xff,t1,t3);
+}
+
+// per lane twiddles for 64 elements: t[0],t[d],t[2d],t[3d] each repeated
+// over a quarter (blocks of 16, d = 2 for the w[2k] table) or t[0..15] (blocks
+// of 4, the even entries of t[0..31] for w[2q])
+__attribute__((target("avx512f")))
+static __m512i _quarters(const uint32_t *t, int d)
+{
+    const __m512i idx = _mm512_setr_epi32(0,0,0,0,d,d,d,d,2*d,2*d,2*d,2*d,
+        3*d,3*d,3*d,3*d);
+    return _mm512_maskz_permutexvar_epi32(0xffff,idx,_mm512_loadu_si512(t));
+}
+
+__attribute__((target("avx512f")))
+static __m512i _evens(const uint32_t *t)
+{
+    const __m512i idx = _mm512_setr_epi32(0,2,4,6,8,10,12,14,16,18,20,22,
+        24,26,28,30);
+    return _mm512_maskz_permutex2var_epi32(0xffff,_mm512_loadu_si512(t),idx,
+        _mm512_loadu_si512(t+16));
+}
+
+// forward radix 4 levels with block sizes 16 and 4 on [lo,hi) with 16 lanes.
+// 64 elements 16b+4j+t are in 4 registers, transposing the quarters puts the
+// arms j of the blocks of 16 in separate registers (lane 4b+t), then
+// transposing within quarters does the same for the arms t (lane 4b+j)
+template <uint32_t P>
+__attribute__((target("avx512f")))
+static void _ntt_last_avx512(uint32_t *a, size_t lo, size_t hi,
+    const _ntt_tables<P>& tb)
+{
+    typedef _avx512_mod<P> V;
+    const uint32_t *w = (const uint32_t*) tb.w.data();
+    const uint32_t *w3 = (const uint32_t*) tb.w3.data();
+    const auto [vi,vip] = V::bconst(*(const uint32_t*) &tb.imag);
+    for (size_t s = lo; s < hi; s += 64)
+    {
+        __m512i a0 = V::load(a+s), a1 = V::load(a+s+16);
+        __m512i a2 = V::load(a+s+32), a3 = V::load(a+s+48);
+        _transpose128(a0,a1,a2,a3);
+        V::fwd4(a0,a1,a2,a3,_quarters(w+s/8,2),_quarters(w+s/16,1),
+            _quarters(w3+s/16,1),vi,vip);
+        _transpose32(a0,a1,a2,a3);
+        V::fwd4(a0,a1,a2,a3,_evens(w+s/2),V::load(w+s/4),V::load(w3+s/4),
+            vi,vip);
+        _transpose32(a0,a1,a2,a3);
+        _transpose128(a0,a1,a2,a3);
+        V::store(a+s,a0);
+        V::store(a+s+16,a1);
+        V::store(a+s+32,a2);
+        V::store(a+s+48,a3);
+    }
+}
+
+// inverse radix 4 levels with block sizes 4 and 16 on [lo,hi)
+template <uint32_t P>
+__attribute__((target("avx2")))
+static void _intt_first_avx2(uint32_t *a, size_t lo, size_t hi,
+    const _ntt_tables<P>& tb)
+{
+    typedef _avx2_mod<P> V;
+    const uint32_t *iw = (const uint32_t*) tb.iw.data();
+    const uint32_t *iw3 = (const uint32_t*) tb.iw3.data();
+    const uint32_t *it1 = (const uint32_t*) tb.it1.data();
+    const uint32_t one = iw[0], iimag = *(const uint32_t*) &tb.iimag;
+    // blocks of 4
+    const __m256i iimag3 = _mm256_setr_epi32(one,one,one,iimag,
+        one,one,one,iimag);
+    for (size_t s = lo; s < hi; s += 8)
+    {
+        const __m256i c = V::load(a+s);
+        const __m256i d = _mm256_shuffle_epi32(c,0xb1); // c1 c0 c3 c2
+        // x z y t
+        const __m256i e = V::mul(_mm256_blend_epi32(V::add(c,d),V::sub(d,c),
+            0xaa),iimag3);
+        const __m256i f = _mm256_shuffle_epi32(e,0x4e); // y t x z
+        V::store(a+s,V::mul(_mm256_blend_epi32(V::add(e,f),V::sub(f,e),0xcc),
+            V::load(it1+s)));
+    }
+    // blocks of 16
+    const __m256i one_iimag = V::halves(one,iimag);
+    for (size_t s = lo, k = lo/16; s < hi; s += 16, ++k)
+    {
+        const __m256i c01 = V::load(a+s), c23 = V::load(a+s+8);
+        const __m256i c10 = _mm256_permute2x128_si256(c01,c01,1);
+        const __m256i c32 = _mm256_permute2x128_si256(c23,c23,1);
+        const __m256i xz = _mm256_blend_epi32(V::add(c01,c10),
+            V::sub(c10,c01),0xf0);
+        const __m256i yt = V::mul(_mm256_blend_epi32(V::add(c23,c32),
+            V::sub(c32,c23),0xf0),one_iimag);
+        V::store(a+s,V::mul(V::add(xz,yt),V::halves(one,iw[2*k])));
+        V::store(a+s+8,V::mul(V::sub(xz,yt),V::halves(iw[k],iw3[k])));
+    }
+}
+
+// inverse of _ntt_last_avx512 in the same layout
+template <uint32_t P>
+__attribute__((target("avx512f")))
+static void _intt_first_avx512(uint32_t *a, size_t lo, size_t hi,
+    const _ntt_tables<P>& tb)
+{
+    typedef _avx512_mod<P> V;
+    const uint32_t *iw = (const uint32_t*) tb.iw.data();
+    const uint32_t *iw3 = (const uint32_t*) tb.iw3.data();
+    const auto [vi,vip] = V::bconst(*(const uint32_t*) &tb.iimag);
+    for (size_t s = lo; s < hi; s += 64)
+    {
+        __m512i a0 = V::load(a+s), a1 = V::load(a+s+16);
+        __m512i a2 = V::load(a+s+32), a3 = V::load(a+s+48);
+        _transpose128(a0,a1,a2,a3);
+        _transpose32(a0,a1,a2,a3);
+        V::inv4(a0,a1,a2,a3,_evens(iw+s/2),V::load(iw+s/4),
+            V::load(iw3+s/4),vi,vip);
+        _transpose32(a0,a1,a2,a3);
+        V::inv4(a0,a1,a2,a3,_quarters(iw+s/8,2),_quarters(iw+s/16,1),
+            _quarters(iw3+s/16,1),vi,vip);
+        _transpose128(a0,a1,a2,a3);
+        V::store(a+s,a0);
+        V::store(a+s+16,a1);
+        V::store(a+s+32,a2);
+        V::store(a+s+48,a3);
+    }
+}
+
+// inverse radix 4 level with block size len >= 64 on blocks in [lo,hi)
+template <uint32_t P>
+__attribute__((target("avx2")))
+static void _intt_level_avx2(uint32_t *a, size_t lo, size_t hi, size_t len,
+    const _ntt_tables<P>& tb)
+{
+    typedef _avx2_mod<P> V;
+    const uint32_t *iw = (const uint32_t*) tb.iw.data();
+    const uint32_t *iw3 = (const uint32_t*) tb.iw3.data();
+    const auto [vi,vip] = V::bconst(*(const uint32_t*) &tb.iimag);
+    const size_t m = len/4;
+    for (size_t s = lo, k = lo/len; s < hi; s += len, ++k)
+    {
+        const auto [iw1,iw1p] = V::bconst(iw[2*k]);
+        const auto [iw2,iw2p] = V::bconst(iw[k]);
+        const auto [iww3,iww3p] = V::bconst(iw3[k]);
+        uint32_t *b = a+s;
+        for (size_t j = 0; j < m; j += 8)
+        {
+            const __m256i c0 = V::load(b+j), c1 = V::load(b+j+m);
+            const __m256i c2 = V::load(b+j+2*m), c3 = V::load(b+j+3*m);
+            const __m256i x = V::add(c0,c1), z = V::sub(c0,c1);
+            const __m256i y = V::add(c2,c3);
+            const __m256i t = V::mul_const(V::sub(c2,c3),vi,vip);
+            V::store(b+j,V::add(x,y));
+            V::store(b+j+m,V::mul_const(V::add(z,t),iw1,iw1p));
+            V::store(b+j+2*m,V::mul_const(V::sub(x,y),iw2,iw2p));
+            V::store(b+j+3*m,V::mul_const(V::sub(z,t),iww3,iww3p));
+        }
+    }
+}
+
+template <uint32_t P>
+__attribute__((target("avx512f")))
+static void _intt_level_avx512(uint32_t *a, size_t lo, size_t hi, size_t len,
+    const _ntt_tables<P>& tb)
+{
+    typedef _avx512_mod<P> V;
+    const uint32_t *iw = (const uint32_t*) tb.iw.data();
+    const uint32_t *iw3 = (const uint32_t*) tb.iw3.data();
+    const auto [vi,vip] = V::bconst(*(const uint32_t*) &tb.iimag);
+    const size_t m = len/4;
+    for (size_t s = lo, k = lo/len; s < hi; s += len, ++k)
+    {
+        const auto [iw1,iw1p] = V::bconst(iw[2*k]);
+        const auto [iw2,iw2p] = V::bconst(iw[k]);
+        const auto [iww3,iww3p] = V::bconst(iw3[k]);
+        uint32_t *b = a+s;
+        for (size_t j = 0; j < m; j += 16)
+        {
+            const __m512i c0 = V::load(b+j), c1 = V::load(b+j+m);
+            const __m512i c2 = V::load(b+j+2*m), c3 = V::load(b+j+3*m);
+            const __m512i x = V::add(c0,c1), z = V::sub(c0,c1);
+            const __m512i y = V::add(c2,c3);
+            const __m512i t = V::mul_const(V::sub(c2,c3),vi,vip);
+            V::store(b+j,V::add(x,y));
+            V::store(b+j+m,V::mul_const(V::add(z,t),iw1,iw1p));
+            V::store(b+j+2*m,V::mul_const(V::sub(x,y),iw2,iw2p));
+            V::store(b+j+3*m,V::mul_const(V::sub(z,t),iww3,iww3p));
+        }
+    }
+}
+
+// a[i] *= b[i]*c, or a[i] *= c when b is null (montgomery values, n >= 8)
+template <uint32_t P>
+__attribute__((target("avx2")))
+static void _pointwise_avx2(uint32_t *a, const uint32_t *b, size_t n,
+    uint32_t c)
+{
+    typedef _avx2_mod<P> V;
+    const __m256i vc = _mm256_set1_epi32(c);
+    for (size_t i = 0; i < n; i += 8)
+    {
+        const __m256i x = V::mul(V::load(a+i),vc);
+        V::store(a+i,b ? V::mul(x,V::load(b+i)) : x);
+    }
+}
+
+template <uint32_t P>
+__attribute__((target("avx512f")))
+static void _pointwise_avx512(uint32_t *a, const uint32_t *b, size_t n,
+    uint32_t c)
+{
+    typedef _avx512_mod<P> V;
+    const __m512i vc = _mm512_set1_epi32(c);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        const __m512i x = V::mul(V::load(a+i),vc);
+        V::store(a+i,b ? V::mul(x,V::load(b+i)) : x);
+    }
+    if (i < n)
+        _pointwise_avx2<P>(a+i,b ? b+i : b,n-i,c);
+}
+
+// radix 4 level with blocks of len >= 64 on [lo,hi) (forward or inverse),
+// a radix 2 level and pointwise products, 16 lanes if available
+template <uint32_t P>
+static void _level(bool inv, uint32_t *a, size_t lo, size_t hi, size_t len,
+    const _ntt_tables<P>& tb)
+{
+    if (_has_avx512())
+        (inv ? _intt_level_avx512<P> : _ntt_level_avx512<P>)(a,lo,hi,len,tb);
+    else
+        (inv ? _intt_level_avx2<P> : _ntt_level_avx2<P>)(a,lo,hi,len,tb);
+}
+
+template <uint32_t P>
+static void _radix2(uint32_t *a, size_t n)
+{
+    (_has_avx512() ? _radix2_avx512<P> : _radix2_avx2<P>)(a,n);
+}
+
+template <uint32_t P>
+static void _pointwise(uint32_t *a, const uint32_t *b, size_t n, uint32_t c)
+{
+    (_has_avx512() ? _pointwise_avx512<P> : _pointwise_avx2<P>)(a,b,n,c);
+}
+
+// levels on blocks up to this size (128 KiB) run one block at a time so the
+// block stays in cache, only the larger levels pass over the whole array
+static const size_t _NTT_CHUNK = 1 << 15;
+
+// size of the blocks that the forward transform finishes one at a time (and
+// the inverse starts with)
+static size_t _ntt_chunk_len(size_t n)
+{
+    size_t len = __builtin_ctzll(n) % 2 ? n/2 : n;
+    while (len > _NTT_CHUNK)
+        len /= 4;
+    return len;
+}
+
+// forward levels with blocks larger than _ntt_chunk_len(n), for n >= 64
+template <uint32_t P>
+static void _ntt_top(uint32_t *a, size_t n, const _ntt_tables<P>& tb)
+{
+    size_t len = n;
+    if (__builtin_ctzll(n) % 2)
+    {
+        _radix2<P>(a,n);
+        len /= 2;
+    }
+    for (; len > _NTT_CHUNK; len /= 4)
+        _level<P>(false,a,0,n,len,tb);
+}
+
+// remaining forward levels on the block [c,c+len)
+template <uint32_t P>
+static void _ntt_block(uint32_t *a, size_t c, size_t len,
+    const _ntt_tables<P>& tb)
+{
+    for (size_t l = len; l >= 64; l /= 4)
+        _level<P>(false,a,c,c+len,l,tb);
+    (_has_avx512() ? _ntt_last_avx512<P> : _ntt_last_avx2<P>)(a,c,c+len,tb);
+}
+
+// first inverse levels on the block [c,c+len)
+template <uint32_t P>
+static void _intt_block(uint32_t *a, size_t c, size_t len,
+    const _ntt_tables<P>& tb)
+{
+    (_has_avx512() ? _intt_first_avx512<P> : _intt_first_avx2<P>)
+        (a,c,c+len,tb);
+    for (size_t l = 64; l <= len; l *= 4)
+        _level<P>(true,a,c,c+len,l,tb);
+}
+
+// inverse levels with blocks larger than _ntt_chunk_len(n), without the
+// division by n
+template <uint32_t P>
+static void _intt_top(uint32_t *a, size_t n, const _ntt_tables<P>& tb)
+{
+    const size_t top = __builtin_ctzll(n) % 2 ? n/2 : n; // radix 4 up to top
+    for (size_t len = 4*_ntt_chunk_len(n); len <= top; len *= 4)
+        _level<P>(true,a,0,n,len,tb);
+    if (top != n)
+        _radix2<P>(a,n);
+}
+
+// forward transform for n >= 64
+template <uint32_t P>
+static void _ntt_avx2(uint32_t *a, size_t n, const _ntt_tables<P>& tb)
+{
+    _ntt_top<P>(a,n,tb);
+    const size_t len = _ntt_chunk_len(n);
+    for (size_t c = 0; c < n; c += len)
+        _ntt_block<P>(a,c,len,tb);
+}
+
+// inverse transform for n >= 64, without the division by n
+template <uint32_t P>
+static void _intt_avx2(uint32_t *a, size_t n, const _ntt_tables<P>& tb)
+{
+    const size_t len = _ntt_chunk_len(n);
+    for (size_t c = 0; c < n; c += len)
+        _intt_block<P>(a,c,len,tb);
+    _intt_top<P>(a,n,tb);
+}
+
+static bool _has_avx2()
+{
+    static const bool ret = __builtin_cpu_supports("avx2");
+    return ret;
+}
+
+// forward transform of length n = 2^j, result in bit reversed order
+template <uint32_t P>
+void ntt(ModInt<P> *a, size_t n)
+{
+    static_assert(sizeof(ModInt<P>) == sizeof(uint32_t));
+    assert((n & (n-1)) == 0);
+    if (n <= 1)
+        return;
+    _ntt_tables<P>& tb = _ntt_tables<P>::get();
+    tb.grow(n);
+    if (n >= 64 && _has_avx2())
+        _ntt_avx2<P>((uint32_t*) a,n,tb);
+    else
+        _ntt_scalar<P>(a,n,tb);
+}
+
+// inverse of ntt (bit reversed input, natural order output) including the
+// division by n
+template <uint32_t P>
+void intt(ModInt<P> *a, size_t n)
+{
+    assert((n & (n-1)) == 0);
+    if (n <= 1)
+        return;
+    _ntt_tables<P>& tb = _ntt_tables<P>::get();
+    tb.grow(n);
+    if (n >= 64 && _has_avx2())
+    {
+        _intt_avx2<P>((uint32_t*) a,n,tb);
+        const ModInt<P> inv_n = ModInt<P>((P+1)/2).pow(__builtin_ctzll(n));
+        _pointwise<P>((uint32_t*) a,nullptr,n,*(const uint32_t*) &inv_n);
+    }
+    else
+        _intt_scalar<P>(a,n,tb);
+}
+
+// product of polynomials (coefficients in increasing degree order)
+template <uint32_t P>
+std::vector<ModInt<P>> convolution(const std::vector<ModInt<P>>& a,
+    const std::vector<ModInt<P>>& b)
+{
+    typedef ModInt<P> M;
+    if (a.empty() || b.empty())
+        return {};
+    const size_t len = a.size() + b.size() - 1;
+    if (std::min(a.size(),b.size()) <= 32) // schoolbook
+    {
+        std::vector<M> ret(len);
+        for (size_t i = 0; i < a.size(); ++i)
+            for (size_t j = 0; j < b.size(); ++j)
+                ret[i+j] += a[i]*b[j];
+        return ret;
+    }
+    size_t n = 1;
+    while (n < len)
+        n *= 2;
+    std::vector<M> fa, fb;
+    fa.reserve(n);
+    fa.assign(a.begin(),a.end());
+    fa.resize(n);
+    fb.reserve(n);
+    fb.assign(b.begin(),b.end());
+    fb.resize(n);
+    if (_has_avx2()) // n >= 128 here
+    {
+        _ntt_tables<P>& tb = _ntt_tables<P>::get();
+        tb.grow(n);
+        uint32_t *ua = (uint32_t*) fa.data(), *ub = (uint32_t*) fb.data();
+        _ntt_top<P>(ua,n,tb);
+        _ntt_top<P>(ub,n,tb);
+        // the last forward levels, product with division by n and first
+        // inverse levels one cache sized block at a time
+        const M inv_n = M((P+1)/2).pow(__builtin_ctzll(n));
+        const size_t len = _ntt_chunk_len(n);
+        for (size_t c = 0; c < n; c += len)
+        {
+            _ntt_block<P>(ua,c,len,tb);
+            _ntt_block<P>(ub,c,len,tb);
+            _pointwise<P>(ua+c,ub+c,len,*(const uint32_t*) &inv_n);
+            _intt_block<P>(ua,c,len,tb);
+        }
+        _intt_top<P>(ua,n,tb);
+    }
+    else
+    {
+        ntt(fa.data(),n);
+        ntt(fb.data(),n);
+        for (size_t i = 0; i < n; ++i)
+            fa[i] *= fb[i];
+        intt(fa.data(),n);
+    }
+    fa.resize(len);
+    return fa;
+}
+
+template <uint32_t P>
+static void _test()
+{
+    typedef ModInt<P> M;
+    std::mt19937_64 rng(P);
+    // the last level splits a mod (x^2 - w[k]^2) into the values at w[k]
+    // and -w[k] in positions 2k and 2k+1
+    for (size_t n = 1; n <= 1024; n *= 2)
+    {
+        std::vector<M> a(n);
+        for (M& x : a)
+            x = rng();
+        std::vector<M> f = a;
+        ntt(f.data(),n);
+        const std::vector<M>& w = _ntt_tables<P>::get().w;
+        for (size_t i = 0; i < n; ++i)
+        {
+            const M x = n == 1 ? M(1) : (i % 2 ? -w[i/2] : w[i/2]);
+            M v = 0;
+            for (size_t k = n; k--;)
+                v = v*x + a[k];
+            assert(f[i] == v);
+        }
+        intt(f.data(),n);
+        assert(f == a);
+    }
+    for (size_t la : {1,2,3,31,32,33,64,100,1000})
+        for (size_t lb : {1,5,32,33,500,1025})
+        {
+            std::vector<M> a(la), b(lb), c(la+lb-1);
+            for (M& x : a)
+                x = rng();
+            for (M& x : b)
+                x = rng();
+            for (size_t i = 0; i < la; ++i)
+                for (size_t j = 0; j < lb; ++j)
+                    c[i+j] += a[i]*b[j];
+            assert(convolution(a,b) == c);
+        }
+    // lengths with several cache blocks, checked at random points
+    for (size_t la : {70000,300000})
+    {
+        std::vector<M> a(la), b(la/2+3);
+        for (M& x : a)
+            x = rng();
+        for (M& x : b)
+            x = rng();
+        const std::vector<M> c = convolution(a,b);
+        for (int t = 0; t < 3; ++t)
+        {
+            const M x = rng();
+            auto eval = [&](const std::vector<M>& f)
+            {
+                M v = 0;
+                for (size_t k = f.size(); k--;)
+                    v = v*x + f[k];
+                return v;
+            };
+            assert(eval(c) == eval(a)*eval(b));
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    _test<998244353>();
+    _test<167772161>();
+    _test<469762049>();
+    _test<754974721>();
+    assert(_ntt_tables<998244353>::G == 3 && _ntt_tables<754974721>::G == 11);
+    assert(_ntt_tables<998244353>::K == 23);
+    typedef ModInt<998244353> M;
+    assert(convolution<998244353>({},{1}).empty());
+    assert(convolution<998244353>({1,2,3},{4,5}) == std::vector<M>({4,13,22,15}));
+
+    // run with "bench" argument for timing
+    if (argc > 1 && std::string(argv[1]) == "bench")
+    {
+        std::mt19937_64 rng(1);
+        for (size_t n : {1 << 16, 1 << 18, 1 << 20})
+        {
+            std::vector<M> a(n), b(n);
+            for (size_t i = 0; i < n; ++i)
+                a[i] = rng(), b[i] = rng();
+            convolution(a,b); // tables
+            const int R = 10;
+            auto t0 = std::chrono::steady_clock::now();
+            std::vector<M> c;
+            for (int r = 0; r < R; ++r)
+                c = convolution(a,b);
+            auto t1 = std::chrono::steady_clock::now();
+            std::vector<M> f(2*n);
+            for (int r = 0; r < R; ++r)
+                ntt(f.data(),2*n);
+            auto t2 = std::chrono::steady_clock::now();
+            // check a few coefficients
+            for (size_t k : {(size_t) 0,n-1,2*n-2})
+            {
+                M v = 0;
+                for (size_t i = k < n ? 0 : k-n+1; i <= std::min(k,n-1); ++i)
+                    v += a[i]*b[k-i];
+                assert(c[k] == v);
+            }
+            auto ms = [&](auto s, auto t)
+            { return std::chrono::duration<double,std::milli>(t-s).count()/R; };
+            printf("n = %zu: convolution %.2f ms, ntt of length %zu %.2f ms\n",
+                n,ms(t0,t1),2*n,ms(t1,t2));
+        }
+    }
+}
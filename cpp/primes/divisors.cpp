@@ -0,0 +1,206 @@
+/*
+Divisor enumeration from a prime factorization
+
+ordered_divisors yields divisors in increasing order on demand using a heap
+merge instead of building and sorting all of them. With primes p_0 < p_1 < ...
+each divisor d > 1 (largest prime p_k with exponent e) has a unique smaller
+parent: d/p_k if e > 1, otherwise d/p_k (if its largest prime is p_{k-1}) or
+d/p_k*p_{k-1}. Popping a divisor pushes its (at most 3) children, so the heap
+holds O(number of divisors produced so far) entries and each step is O(log).
+
+divisors_unordered writes all divisors into a caller provided buffer without
+allocating (size it with divisor_count).
+*/
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <queue>
+#include <string>
+#include <utility>
+#include <vector>
+
+// prime factorization as (prime,exponent) pairs with increasing primes
+typedef std::vector<std::pair<uint64_t,uint32_t>> prime_powers;
+
+class ordered_divisors
+{
+    struct _node
+    {
+        uint64_t v; // divisor
+        uint32_t k; // index of its largest prime
+        uint32_t e; // exponent of that prime
+        bool operator>(const _node& o) const { return v > o.v; }
+    };
+    prime_powers _pf;
+    std::priority_queue<_node,std::vector<_node>,std::greater<_node>> _heap;
+    bool _started;
+
+public:
+    ordered_divisors(const prime_powers& pf): _pf(pf), _started(false)
+    {
+        // exponent 0 entries are not part of the factorization
+        _pf.erase(std::remove_if(_pf.begin(),_pf.end(),
+            [](const std::pair<uint64_t,uint32_t>& pe)
+            { return pe.second == 0; }),_pf.end());
+    }
+
+    // returns false when all divisors have been produced
+    bool next(uint64_t& d)
+    {
+        if (!_started)
+        {
+            _started = true;
+            if (!_pf.empty())
+                _heap.push({_pf[0].first,0,1});
+            d = 1;
+            return true;
+        }
+        if (_heap.empty())
+            return false;
+        const _node t = _heap.top();
+        _heap.pop();
+        d = t.v;
+        const uint64_t p = _pf[t.k].first;
+        if (t.e < _pf[t.k].second)
+            _heap.push({t.v*p,t.k,t.e+1});
+        if (t.k+1 < _pf.size())
+        {
+            const uint64_t q = _pf[t.k+1].first;
+            _heap.push({t.v*q,t.k+1,1});
+            if (t.e == 1)
+                _heap.push({t.v/p*q,t.k+1,1});
+        }
+        return true;
+    }
+};
+
+// number of divisors
+uint64_t divisor_count(const prime_powers& pf)
+{
+    uint64_t ret = 1;
+    for (const auto& [p,e] : pf)
+        ret *= e+1;
+    return ret;
+}
+
+// writes the divisors (unordered) to out, which must have divisor_count(pf)
+// elements, and returns the number written
+size_t divisors_unordered(const prime_powers& pf, uint64_t *out)
+{
+    size_t cnt = 1;
+    out[0] = 1;
+    for (const auto& [p,e] : pf)
+    {
+        const size_t len = cnt;
+        for (uint32_t i = 0; i < e; ++i)
+            for (size_t j = 0; j < len; ++j, ++cnt)
+                out[cnt] = out[cnt-len]*p;
+    }
+    return cnt;
+}
+
+// sorted list of divisors
+std::vector<uint64_t> list_divisors(const prime_powers& pf)
+{
+    std::vector<uint64_t> ret;
+    ret.reserve(divisor_count(pf));
+    ordered_divisors gen(pf);
+    for (uint64_t d; gen.next(d);)
+        ret.push_back(d);
+    return ret;
+}
+
+// trial division factorization for the tests
+static prime_powers _factor(uint64_t n)
+{
+    prime_powers ret;
+    for (uint64_t d = 2; d*d <= n; ++d)
+        if (n % d == 0)
+        {
+            ret.push_back({d,0});
+            for (; n % d == 0; n /= d)
+                ++ret.back().second;
+        }
+    if (n != 1)
+        ret.push_back({n,1});
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    for (uint64_t n = 1; n <= 5000; ++n)
+    {
+        std::vector<uint64_t> naive;
+        for (uint64_t d = 1; d <= n; ++d)
+            if (n % d == 0)
+                naive.push_back(d);
+        const prime_powers pf = _factor(n);
+        assert(list_divisors(pf) == naive);
+        assert(divisor_count(pf) == naive.size());
+        std::vector<uint64_t> buf(divisor_count(pf));
+        assert(divisors_unordered(pf,buf.data()) == buf.size());
+        std::sort(buf.begin(),buf.end());
+        assert(buf == naive);
+    }
+    assert(list_divisors({}) == std::vector<uint64_t>({1}));
+    assert(list_divisors({{73,1},{137,1},{99990001,1}})
+        == std::vector<uint64_t>({1,73,137,10001,99990001,7299270073ull,
+        13698630137ull,1000000000001ull}));
+    assert(list_divisors({{101,2}}) == std::vector<uint64_t>({1,101,10201}));
+
+    // highly composite
+    const uint64_t hc = 963761198400ull;
+    const prime_powers hpf = _factor(hc);
+    assert(divisor_count(hpf) == 6720);
+    std::vector<uint64_t> all(6720);
+    divisors_unordered(hpf,all.data());
+    std::sort(all.begin(),all.end());
+    assert(list_divisors(hpf) == all);
+
+    // run with "bench" argument for timing
+    if (argc > 1 && std::string(argv[1]) == "bench")
+    {
+        const prime_powers pf = _factor(897612484786617600ull);
+        const uint64_t cnt = divisor_count(pf);
+        const int R = 20;
+        std::vector<uint64_t> buf(cnt);
+        auto t0 = std::chrono::steady_clock::now();
+        for (int r = 0; r < R; ++r)
+            divisors_unordered(pf,buf.data());
+        auto t1 = std::chrono::steady_clock::now();
+        for (int r = 0; r < R; ++r)
+        {
+            divisors_unordered(pf,buf.data());
+            std::sort(buf.begin(),buf.end());
+        }
+        auto t2 = std::chrono::steady_clock::now();
+        uint64_t s = 0;
+        for (int r = 0; r < R; ++r)
+        {
+            ordered_divisors gen(pf);
+            for (uint64_t d; gen.next(d);)
+                s += d;
+        }
+        auto t3 = std::chrono::steady_clock::now();
+        for (int r = 0; r < R; ++r)
+        {
+            ordered_divisors gen(pf);
+            uint64_t d;
+            for (int i = 0; i < 100 && gen.next(d); ++i)
+                s += d;
+        }
+        auto t4 = std::chrono::steady_clock::now();
+        auto ms = [&](auto a, auto b)
+        { return std::chrono::duration<double,std::milli>(b-a).count()/R; };
+        printf("n = 897612484786617600 (%llu divisors)\n",
+            (unsigned long long) cnt);
+        printf("unordered into buffer: %.3f ms\n",ms(t0,t1));
+        printf("unordered + sort: %.3f ms\n",ms(t1,t2));
+        printf("ordered generator (all): %.3f ms\n",ms(t2,t3));
+        printf("ordered generator (first 100): %.3f ms\n",ms(t3,t4));
+        printf("checksum %llu\n",(unsigned long long) s);
+    }
+}
@@ -0,0 +1,209 @@
+/*
+Deterministic Miller Rabin primality test for 64 bit integers
+
+Arithmetic modulo n is done in Montgomery form (R = 2^64) using 128 bit
+products, avoiding the hardware 128/64 division in the modular exponentiation.
+The base sets are known to have no strong pseudoprimes in their range:
+- n < 2^32: bases 2, 7, 61
+- n < 2^64: bases 2, 325, 9375, 28178, 450775, 9780504, 1795265022 (Jim Sinclair)
+*/
+
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+typedef unsigned __int128 u128;
+
+// montgomery arithmetic modulo odd n (values are in [0,n))
+struct mont64
+{
+    uint64_t n;   // modulus (odd)
+    uint64_t inv; // n^-1 mod 2^64
+    uint64_t r2;  // 2^128 mod n
+    uint64_t one; // 2^64 mod n (1 in montgomery form)
+
+    mont64(uint64_t n): n(n)
+    {
+        assert(n % 2 == 1);
+        inv = n; // correct to 3 bits, newton doubles the correct bits
+        for (int i = 0; i < 5; ++i)
+            inv *= 2 - n*inv;
+        one = -n % n;
+        r2 = (u128) one * one % n;
+    }
+
+    // t * 2^-64 mod n for t < n * 2^64
+    uint64_t reduce(u128 t) const
+    {
+        const uint64_t m = (uint64_t) t * inv;
+        const uint64_t hi = t >> 64, mn = ((u128) m * n) >> 64;
+        // low 64 bits of t and m*n are equal, so t-m*n = (hi-mn) * 2^64
+        return hi >= mn ? hi - mn : hi - mn + n;
+    }
+
+    uint64_t mul(uint64_t a, uint64_t b) const { return reduce((u128) a * b); }
+    // convert a < n into montgomery form
+    uint64_t to(uint64_t a) const { return mul(a,r2); }
+    // convert from montgomery form
+    uint64_t from(uint64_t a) const { return reduce(a); }
+
+    // a^p (a and result in montgomery form)
+    uint64_t pow(uint64_t a, uint64_t p) const
+    {
+        uint64_t ret = one;
+        for (; p; p >>= 1)
+        {
+            if (p & 1)
+                ret = mul(ret,a);
+            a = mul(a,a);
+        }
+        return ret;
+    }
+};
+
+// strong probable prime test for odd n > 2 with n-1 = d * 2^s
+static bool _sprp_round(const mont64& m, uint64_t b, uint64_t d, int s)
+{
+    b %= m.n;
+    if (b == 0) // base is a multiple of n, provides no information
+        return true;
+    const uint64_t mone = m.n - m.one; // -1 in montgomery form
+    uint64_t x = m.pow(m.to(b),d);
+    if (x == m.one || x == mone)
+        return true;
+    for (int r = 1; r < s; ++r)
+    {
+        x = m.mul(x,x);
+        if (x == mone)
+            return true;
+        if (x == m.one)
+            return false;
+    }
+    return false;
+}
+
+// strong pseudoprime test n with base b (requires 1 < b < n-1 for n > 3)
+bool is_sprp(uint64_t n, uint64_t b)
+{
+    if (n < 2)
+        return false;
+    if (n < 4) // 2,3
+        return true;
+    assert(1 < b && b < n-1);
+    if (n % 2 == 0)
+        return false;
+    const int s = __builtin_ctzll(n-1);
+    return _sprp_round(mont64(n),b,(n-1) >> s,s);
+}
+
+// deterministic primality test for all 64 bit integers
+bool is_prime(uint64_t n)
+{
+    if (n < 64)
+        return (0x28208a20a08a28acull >> n) & 1;
+    // small factors reject most composites cheaply
+    if (n % 2 == 0 || n % 3 == 0 || n % 5 == 0 || n % 7 == 0 || n % 11 == 0
+        || n % 13 == 0 || n % 17 == 0 || n % 19 == 0 || n % 23 == 0
+        || n % 29 == 0 || n % 31 == 0 || n % 37 == 0 || n % 41 == 0
+        || n % 43 == 0 || n % 47 == 0 || n % 53 == 0 || n % 59 == 0
+        || n % 61 == 0)
+        return false;
+    if (n < 67*67)
+        return true;
+    const mont64 m(n);
+    const int s = __builtin_ctzll(n-1);
+    const uint64_t d = (n-1) >> s;
+    if (n < (1ull << 32))
+    {
+        for (uint64_t b : {2,7,61})
+            if (!_sprp_round(m,b,d,s))
+                return false;
+        return true;
+    }
+    for (uint64_t b : {2ull,325ull,9375ull,28178ull,450775ull,9780504ull,
+            1795265022ull})
+        if (!_sprp_round(m,b,d,s))
+            return false;
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    // compare with a sieve
+    const uint32_t N = 2000000;
+    std::string comp(N,0);
+    for (uint64_t i = 2; i*i < N; ++i)
+        if (!comp[i])
+            for (uint64_t j = i*i; j < N; j += i)
+                comp[j] = 1;
+    for (uint64_t n = 0; n < N; ++n)
+        assert(is_prime(n) == (n >= 2 && !comp[n]));
+
+    // is_sprp
+    for (uint64_t n : {3,5,7,11,13,17,19,23,29,31,37,41,43,47,53,59,61,67,71,
+            73,79,83,89,97})
+    {
+        assert(is_sprp(n,2));
+        assert(n == 3 || is_sprp(n,3));
+    }
+    assert(!is_sprp(0,2) && !is_sprp(1,2) && is_sprp(2,2) && is_sprp(3,2));
+    assert(!is_sprp(341,2));
+    assert(is_sprp(2047,2)); // 2047 = 23*89
+    assert(!is_sprp(561,2) && !is_sprp(561,3));
+
+    // strong pseudoprimes to many small prime bases
+    assert(is_sprp(3215031751ull,2) && is_sprp(3215031751ull,7));
+    assert(!is_prime(3215031751ull)); // 151*751*28351
+    assert(!is_prime(3825123056546413051ull)); // spsp to bases 2..37
+    assert(!is_prime(4759123141ull)); // 48781*97561, spsp(2,7,61)
+
+    // large primes and composites
+    assert(is_prime(1000000007ull) && is_prime(4294967291ull));
+    assert(is_prime(1000000000039ull) && !is_prime(1000000000001ull));
+    assert(is_prime((1ull << 61) - 1) && !is_prime((1ull << 62) - 1));
+    assert(is_prime(1000000000000000003ull));
+    assert(is_prime(18446744073709551557ull)); // largest 64 bit prime
+    assert(!is_prime(18446744073709551615ull));
+    assert(!is_prime(4294967291ull * 4294967279ull));
+    assert(!is_prime(1000000007ull * 998244353ull));
+    uint64_t cnt = 0;
+    for (uint64_t n = 18446744073709551615ull - 10000; n != 0; ++n)
+        cnt += is_prime(n);
+    assert(cnt == 218);
+
+    // run with "bench" argument for timing
+    if (argc > 1 && std::string(argv[1]) == "bench")
+    {
+        const uint64_t T = 10000000;
+        for (uint64_t lo : {1000000000ull,1ull << 40,1ull << 63})
+        {
+            auto t0 = std::chrono::steady_clock::now();
+            uint64_t c = 0;
+            for (uint64_t n = lo; n < lo+T; ++n)
+                c += is_prime(n);
+            auto t1 = std::chrono::steady_clock::now();
+            double sec = std::chrono::duration<double>(t1-t0).count();
+            printf("[%llu,+%llu): %llu primes, %.3e tests/sec\n",
+                (unsigned long long) lo,(unsigned long long) T,
+                (unsigned long long) c,T/sec);
+        }
+        // worst case input (all bases run on primes)
+        std::vector<uint64_t> primes;
+        for (uint64_t n = 1ull << 63; primes.size() < 1000; ++n)
+            if (is_prime(n))
+                primes.push_back(n);
+        const uint64_t R = 1000;
+        auto t0 = std::chrono::steady_clock::now();
+        uint64_t c = 0;
+        for (uint64_t r = 0; r < R; ++r)
+            for (uint64_t p : primes)
+                c += is_prime(p);
+        auto t1 = std::chrono::steady_clock::now();
+        double sec = std::chrono::duration<double>(t1-t0).count();
+        printf("primes above 2^63: %llu tests, %.3e tests/sec\n",
+            (unsigned long long) c,c/sec);
+    }
+}
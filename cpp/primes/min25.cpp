@@ -0,0 +1,232 @@
+/*
+Min_25 sieve for prefix sums of multiplicative functions
+
+Computes sum_{i=1}^{n} f(i) for a multiplicative f in about O(n^(3/4)/log(n))
+time and O(sqrt(n)) memory, given
+- f(p) as a polynomial in p: f(p) = sum_k coef[k] * p^k (0 <= k <= 2)
+- f(p^e) for prime powers through a function fpe(p,e,p^e)
+
+Phase 1 (like Lucy DP) computes sum_{p <= v} p^k over primes for every
+v = floor(n/i). Phase 2 adds the composite terms recursively by smallest prime
+factor: S(x,t) = sum of f(i) for 2 <= i <= x with all prime factors > p_t.
+
+T is the value type, any ring with +, -, * and construction from a u128
+(the integer sums here use u128, which is exact for the tests and benchmarks
+and otherwise wraps modulo 2^128).
+*/
+
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+typedef unsigned __int128 u128;
+
+template <typename T, typename F>
+class _min25
+{
+    uint64_t _n, _r;
+    F& _fpe;
+    std::vector<uint64_t> _primes; // up to sqrt(n)
+    std::vector<T> _fp_pre;        // _fp_pre[t] = f(p_1)+..+f(p_t)
+    std::vector<uint64_t> _w;      // distinct floor(n/i), decreasing
+    std::vector<uint32_t> _id1, _id2;
+    std::vector<T> _g;             // sum of f(p) for primes p <= _w[j]
+
+    size_t _id(uint64_t v) const { return v <= _r ? _id1[v] : _id2[_n/v]; }
+
+    // sum_{i=2}^{v} i^k
+    static T _power_sum(uint64_t v, size_t k)
+    {
+        const u128 x = v;
+        if (k == 0)
+            return T(x-1);
+        if (k == 1)
+            return T((x % 2 ? x*((x+1)/2) : (x/2)*(x+1)) - 1);
+        // v(v+1)(2v+1)/6 with exact division before overflow is possible
+        u128 a = x, b = x+1, c = 2*x+1;
+        (a % 2 ? b : a) /= 2;
+        (a % 3 == 0 ? a : (b % 3 == 0 ? b : c)) /= 3;
+        return T(a*b*c - 1);
+    }
+
+    // sum of f(i) for 2 <= i <= x with all prime factors > p_t (1 indexed)
+    T _s(uint64_t x, size_t t)
+    {
+        if (x < 2 || (t > 0 && _primes[t-1] >= x)) // no allowed primes
+            return T(0);
+        T ret = _g[_id(x)] - _fp_pre[t];
+        for (size_t i = t; i < _primes.size() && _primes[i]*_primes[i] <= x;
+            ++i)
+        {
+            const uint64_t p = _primes[i];
+            uint64_t pe = p;
+            for (uint32_t e = 1; pe*p <= x; ++e, pe *= p)
+                ret = ret + _fpe(p,e,pe)*_s(x/pe,i+1) + _fpe(p,e+1,pe*p);
+        }
+        return ret;
+    }
+
+public:
+    _min25(uint64_t n, const std::vector<T>& coef, F& fpe): _n(n),
+        _fpe(fpe)
+    {
+        _r = std::sqrt((double) n);
+        while (_r*_r > n)
+            --_r;
+        while ((_r+1)*(_r+1) <= n)
+            ++_r;
+        std::vector<bool> comp(_r+1,false);
+        for (uint64_t i = 2; i <= _r; ++i)
+            if (!comp[i])
+            {
+                _primes.push_back(i);
+                for (uint64_t j = i*i; j <= _r; j += i)
+                    comp[j] = true;
+            }
+        _id1.resize(_r+1);
+        _id2.resize(_r+1);
+        for (uint64_t i = 1; i <= n; i = n/(n/i)+1)
+        {
+            const uint64_t v = n/i;
+            (v <= _r ? _id1[v] : _id2[n/v]) = _w.size();
+            _w.push_back(v);
+        }
+        _g.assign(_w.size(),T(0));
+        _fp_pre.assign(_primes.size()+1,T(0));
+        // phase 1 separately for each power p^k
+        for (size_t k = 0; k < coef.size(); ++k)
+        {
+            std::vector<T> g(_w.size());
+            for (size_t j = 0; j < _w.size(); ++j)
+                g[j] = _power_sum(_w[j],k);
+            T pre(0); // sum of p^k over primes before p
+            for (size_t t = 0; t < _primes.size(); ++t)
+            {
+                const uint64_t p = _primes[t];
+                const T w(k == 0 ? 1 : (k == 1 ? (u128) p : (u128) p*p));
+                for (size_t j = 0; j < _w.size() && p*p <= _w[j]; ++j)
+                    g[j] = g[j] - w*(g[_id(_w[j]/p)] - pre);
+                pre = pre + w;
+                _fp_pre[t+1] = _fp_pre[t+1] + coef[k]*pre;
+            }
+            for (size_t j = 0; j < _w.size(); ++j)
+                _g[j] = _g[j] + coef[k]*g[j];
+        }
+    }
+
+    T sum() { return T(1) + _s(_n,0); }
+};
+
+// sum_{i=1}^{n} f(i) for multiplicative f with f(p) = sum_k coef[k]*p^k
+// (coef has at most 3 terms) and f(p^e) = fpe(p,e,p^e)
+template <typename T, typename F>
+T min25_sum(uint64_t n, const std::vector<T>& coef, F fpe)
+{
+    assert(coef.size() <= 3);
+    if (n == 0)
+        return T(0);
+    return _min25<T,F>(n,coef,fpe).sum();
+}
+
+// sum of euler totient phi(i) for 1 <= i <= n
+u128 totient_sum(uint64_t n)
+{
+    return min25_sum<u128>(n,{(u128) -1,1},
+        [](uint64_t p, uint32_t, uint64_t pe) { return (u128) (pe - pe/p); });
+}
+
+// mertens function (sum of mobius mu(i) for 1 <= i <= n)
+int64_t mertens(uint64_t n)
+{
+    return (int64_t) min25_sum<u128>(n,{(u128) -1},
+        [](uint64_t, uint32_t e, uint64_t) { return e == 1 ? (u128) -1 : 0; });
+}
+
+// sum of sigma_k(i) = sum of d^k over divisors d of i, for 1 <= i <= n, k <= 2
+u128 divisor_sigma_sum(uint64_t n, uint32_t k)
+{
+    assert(k <= 2);
+    std::vector<u128> coef(k+1,0);
+    coef[0] += 1;
+    coef[k] += 1;
+    return min25_sum<u128>(n,coef,[k](uint64_t p, uint32_t e, uint64_t)
+    {
+        u128 ret = 1, pk = k == 0 ? 1 : (k == 1 ? p : p*p), t = 1;
+        for (uint32_t i = 0; i < e; ++i)
+            ret += t *= pk;
+        return ret;
+    });
+}
+
+int main(int argc, char **argv)
+{
+    // brute force with a linear sieve
+    const uint32_t N = 1000000;
+    std::vector<uint32_t> lp(N+1,0), primes;
+    std::vector<int64_t> phi(N+1), mu(N+1), d0(N+1), d1(N+1), d2(N+1);
+    phi[1] = mu[1] = d0[1] = d1[1] = d2[1] = 1;
+    for (uint64_t i = 2; i <= N; ++i)
+    {
+        if (lp[i] == 0)
+            lp[i] = i, primes.push_back(i);
+        // factor out the smallest prime power to use multiplicativity
+        uint64_t p = lp[i], pe = 1, rest = i;
+        uint32_t e = 0;
+        while (rest % p == 0)
+            rest /= p, pe *= p, ++e;
+        int64_t s0 = e+1, s1 = 0, s2 = 0;
+        for (uint64_t q = 1, j = 0; j <= e; ++j, q *= p)
+            s1 += q, s2 += q*q;
+        phi[i] = phi[rest]*(pe-pe/p);
+        mu[i] = e > 1 ? 0 : -mu[rest];
+        d0[i] = d0[rest]*s0;
+        d1[i] = d1[rest]*s1;
+        d2[i] = d2[rest]*s2;
+        for (uint32_t q : primes)
+        {
+            if (q > lp[i] || q*i > N)
+                break;
+            lp[q*i] = q;
+        }
+    }
+    u128 sphi = 0, s0 = 0, s1 = 0, s2 = 0;
+    int64_t smu = 0;
+    for (uint64_t n = 1; n <= N; ++n)
+    {
+        sphi += phi[n];
+        smu += mu[n];
+        s0 += d0[n];
+        s1 += d1[n];
+        s2 += d2[n];
+        if (n <= 300 || n % 99991 == 0 || n == N)
+        {
+            assert(totient_sum(n) == sphi);
+            assert(mertens(n) == smu);
+            assert(divisor_sigma_sum(n,0) == s0);
+            assert(divisor_sigma_sum(n,1) == s1);
+            assert(divisor_sigma_sum(n,2) == s2);
+        }
+    }
+    assert(totient_sum(0) == 0 && mertens(0) == 0);
+    assert(mertens(1000000000) == -222);
+
+    // run with "bench" argument for timing
+    if (argc > 1 && std::string(argv[1]) == "bench")
+        for (uint64_t n = 1000000000; n <= 100000000000ull; n *= 10)
+        {
+            auto t0 = std::chrono::steady_clock::now();
+            const u128 s = totient_sum(n);
+            auto t1 = std::chrono::steady_clock::now();
+            const int64_t m = mertens(n);
+            auto t2 = std::chrono::steady_clock::now();
+            auto sec = [](auto a, auto b)
+            { return std::chrono::duration<double>(b-a).count(); };
+            printf("n = %llu: totient sum %.3f sec (low 64 bits %llu), "
+                "mertens %.3f sec (= %lld)\n",(unsigned long long) n,sec(t0,t1),
+                (unsigned long long) s,sec(t1,t2),(long long) m);
+        }
+}
@@ -0,0 +1,363 @@
+/*
+Integer factorization with Pollard rho (Brent variant) for 64 and 128 bit
+
+Small factors are removed by trial division, then composites are split with
+Brent's cycle finding on x -> x^2+c in Montgomery form. The gcd is batched:
+differences are multiplied together for many steps before one gcd, with a
+backtrack if the batch overshoots to n. Primality uses Miller Rabin, which is
+deterministic for n < 2^64 (7 bases) and for n < 3.3*10^24 (first 13 primes as
+bases). Above that it is a probable prime test with the first 20 primes as
+fixed bases, with no proven error bound (the 4^-k bound is for random bases,
+and strong pseudoprimes to a fixed set of bases can be constructed).
+*/
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+typedef unsigned __int128 u128;
+
+// high half of the full product a*b
+static inline uint64_t _mul_hi(uint64_t a, uint64_t b)
+{
+    return ((u128) a * b) >> 64;
+}
+
+static inline u128 _mul_hi(u128 a, u128 b)
+{
+    const uint64_t a0 = a, a1 = a >> 64, b0 = b, b1 = b >> 64;
+    const u128 p00 = (u128) a0*b0, p01 = (u128) a0*b1;
+    const u128 p10 = (u128) a1*b0, p11 = (u128) a1*b1;
+    const u128 mid = (p00 >> 64) + (uint64_t) p01 + (uint64_t) p10;
+    return p11 + (p01 >> 64) + (p10 >> 64) + (mid >> 64);
+}
+
+static inline int _ctz(uint64_t a) { return __builtin_ctzll(a); }
+
+static inline int _ctz(u128 a)
+{
+    return (uint64_t) a ? __builtin_ctzll(a) : 64 + __builtin_ctzll(a >> 64);
+}
+
+// binary gcd
+template <typename U>
+U _gcd(U a, U b)
+{
+    if (a == 0 || b == 0)
+        return a | b;
+    const int k = _ctz(a | b);
+    a >>= _ctz(a);
+    while (b)
+    {
+        b >>= _ctz(b);
+        if (a > b)
+            std::swap(a,b);
+        b -= a;
+    }
+    return a << k;
+}
+
+// montgomery arithmetic modulo odd n with R = 2^bits(U) (values in [0,n))
+template <typename U>
+struct _mont
+{
+    U n, inv, one, r2;
+
+    _mont(U n): n(n)
+    {
+        inv = n; // correct to 3 bits, newton doubles the correct bits
+        for (int i = 0; i < 7; ++i)
+            inv *= 2 - n*inv;
+        one = -n % n;
+        if constexpr (std::is_same_v<U,uint64_t>)
+            r2 = (u128) one * one % n;
+        else
+        {
+            r2 = one; // double R mod n another bits(U) times
+            for (int i = 0; i < 128; ++i)
+                r2 = r2 >= n - r2 ? r2 - (n - r2) : r2 + r2;
+        }
+    }
+
+    // a*b*R^-1 mod n
+    U mul(U a, U b) const
+    {
+        const U m = a*b*inv;
+        // low halves of a*b and m*n are equal so only high halves matter
+        const U hi = _mul_hi(a,b), mn = _mul_hi(m,n);
+        return hi >= mn ? hi - mn : hi - mn + n;
+    }
+
+    U add(U a, U b) const { return a >= n - b ? a - (n - b) : a + b; }
+    U sub(U a, U b) const { return a >= b ? a - b : a - b + n; }
+    U to(U a) const { return mul(a % n,r2); }
+
+    U pow(U a, U p) const
+    {
+        U ret = one;
+        for (; p; p >>= 1)
+        {
+            if (p & 1)
+                ret = mul(ret,a);
+            a = mul(a,a);
+        }
+        return ret;
+    }
+};
+
+// miller rabin for odd n > 2
+template <typename U>
+bool _miller_rabin(U n, std::initializer_list<uint64_t> bases)
+{
+    const _mont<U> m(n);
+    const int s = _ctz(n-1);
+    const U d = (n-1) >> s, mone = n - m.one;
+    for (uint64_t b : bases)
+    {
+        if (b % n == 0)
+            continue;
+        U x = m.pow(m.to(b),d);
+        if (x == m.one || x == mone)
+            continue;
+        int r = 1;
+        for (; r < s; ++r)
+        {
+            x = m.mul(x,x);
+            if (x == mone)
+                break;
+        }
+        if (r == s)
+            return false;
+    }
+    return true;
+}
+
+static constexpr uint32_t _SMALL_PRIMES[] = {2,3,5,7,11,13,17,19,23,29,31,37,
+    41,43,47,53,59,61,67,71,73,79,83,89,97};
+
+template <typename U>
+bool is_prime(U n)
+{
+    if (n < 2)
+        return false;
+    for (uint32_t p : _SMALL_PRIMES)
+        if (n % p == 0)
+            return n == p;
+    if (n < 97*97)
+        return true;
+    if (n >> 63 >> 1 == 0)
+        return _miller_rabin<uint64_t>(n,{2,325,9375,28178,450775,9780504,
+            1795265022});
+    return _miller_rabin<U>(n,{2,3,5,7,11,13,17,19,23,29,31,37,41,43,47,53,59,
+        61,67,71});
+}
+
+// nontrivial factor of odd composite n (n not a prime power of a small prime)
+template <typename U>
+U _pollard_brent(U n)
+{
+    const _mont<U> m(n);
+    const uint64_t M = 128; // differences multiplied per gcd
+    for (uint64_t c0 = 1;; ++c0)
+    {
+        const U c = m.to(c0);
+        auto f = [&](U x) { return m.add(m.mul(x,x),c); };
+        U x = m.one, y = x, ys = x, q = m.one, g = 1;
+        for (uint64_t r = 1; g == 1; r <<= 1)
+        {
+            x = y;
+            for (uint64_t i = 0; i < r; ++i)
+                y = f(y);
+            for (uint64_t k = 0; k < r && g == 1; k += M)
+            {
+                ys = y;
+                for (uint64_t i = 0; i < M && i < r-k; ++i)
+                {
+                    y = f(y);
+                    q = m.mul(q,m.sub(x,y));
+                }
+                // q is in montgomery form, gcd(q*R,n) = gcd(q,n)
+                g = _gcd(q,n);
+            }
+        }
+        if (g == n) // batch overshot, redo it one step at a time
+            do
+            {
+                ys = f(ys);
+                g = _gcd(m.sub(x,ys),n);
+            }
+            while (g == 1);
+        if (g != n)
+            return g;
+    }
+}
+
+template <typename U>
+void _factor_rec(U n, std::vector<U>& out)
+{
+    if (n == 1)
+        return;
+    if (is_prime(n))
+    {
+        out.push_back(n);
+        return;
+    }
+    if constexpr (!std::is_same_v<U,uint64_t>)
+        if (n >> 64 == 0) // faster 64 bit arithmetic
+        {
+            std::vector<uint64_t> f;
+            _factor_rec<uint64_t>(n,f);
+            out.insert(out.end(),f.begin(),f.end());
+            return;
+        }
+    const U d = _pollard_brent(n);
+    _factor_rec(d,out);
+    _factor_rec(n/d,out);
+}
+
+// prime factorization (increasing order with correct multiplicity)
+template <typename U>
+std::vector<U> _factorization(U n)
+{
+    assert(n > 0);
+    std::vector<U> ret;
+    if (n % 2 == 0)
+    {
+        const int e = _ctz(n);
+        ret.insert(ret.end(),e,2);
+        n >>= e;
+    }
+    // trial division by small odd integers
+    for (uint32_t d = 3; d < 1024 && (U) d*d <= n; d += 2)
+        while (n % d == 0)
+        {
+            ret.push_back(d);
+            n /= d;
+        }
+    if (n < 1024*1024)
+    {
+        if (n != 1)
+            ret.push_back(n);
+        return ret;
+    }
+    _factor_rec(n,ret);
+    std::sort(ret.begin(),ret.end());
+    return ret;
+}
+
+std::vector<uint64_t> factorization(uint64_t n)
+{
+    return _factorization(n);
+}
+
+std::vector<u128> factorization128(u128 n)
+{
+    return _factorization(n);
+}
+
+// parse a decimal string into a 128 bit integer
+static u128 _u128(const char *s)
+{
+    u128 ret = 0;
+    while (*s)
+        ret = 10*ret + (*s++ - '0');
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    typedef std::vector<uint64_t> V;
+    for (uint64_t n = 1; n <= 100000; ++n)
+    {
+        V f = factorization(n);
+        uint64_t prod = 1;
+        for (uint64_t p : f)
+        {
+            assert(is_prime(p));
+            prod *= p;
+        }
+        assert(prod == n && std::is_sorted(f.begin(),f.end()));
+    }
+    assert(factorization(1).empty());
+    for (uint64_t p : {2,3,5,7,23,41,59,73,97})
+        assert(factorization(p) == V({p}));
+    assert(factorization(1260) == V({2,2,3,3,5,7}));
+    assert(factorization(13435741) == V({11,31,31,31,41}));
+    assert(factorization(76998691) == V({7,11,999983}));
+    assert(factorization(1000000000001ull) == V({73,137,99990001}));
+    assert(factorization(6335291110119413ull)
+        == V({13,13,61,71,89,89,103,103,103}));
+    assert(factorization(66049) == V({257,257}));
+    assert(factorization(141420761) == V({521,521,521}));
+    assert(factorization(1000000000039ull) == V({1000000000039ull}));
+    assert(factorization(1000000007ull*998244353ull)
+        == V({998244353,1000000007}));
+    assert(factorization(4294967291ull*4294967279ull)
+        == V({4294967279ull,4294967291ull}));
+    assert(factorization(1000003ull*1000003ull*1000003ull)
+        == V({1000003,1000003,1000003}));
+    assert(factorization(18446744073709551615ull)
+        == V({3,5,17,257,641,65537,6700417}));
+    assert(factorization(18446744073709551557ull)
+        == V({18446744073709551557ull}));
+    assert(factorization(1ull << 63) == V(63,2));
+    assert(factorization(3825123056546413051ull) == V({149491,747451,34233211}));
+
+    typedef std::vector<u128> W;
+    const u128 all = ~(u128) 0; // 2^128-1
+    assert(factorization128(all) == W({3,5,17,257,641,65537,274177,6700417,
+        67280421310721ull}));
+    assert(factorization128(((u128) 1 << 127) - 1)
+        == W({((u128) 1 << 127) - 1}));
+    assert(factorization128((u128) 1000000000039ull * 1000000000039ull
+        * 99990001) == W({99990001,1000000000039ull,1000000000039ull}));
+    const u128 p30 = _u128("1000000000000000000000000000057"); // prime
+    assert(factorization128(p30) == W({p30}));
+    assert(factorization128(p30*97*97) == W({97,97,p30}));
+    assert(factorization128((u128) 1000000007 * 1000000009
+        * 1000000021 * 1000000033) == W({1000000007,1000000009,1000000021,
+        1000000033}));
+
+    // run with "bench" argument for timing
+    if (argc > 1 && std::string(argv[1]) == "bench")
+    {
+        std::mt19937_64 rng(12345);
+        auto rand_prime = [&](uint64_t bits)
+        {
+            for (;;)
+            {
+                uint64_t p = (rng() >> (64-bits)) | (1ull << (bits-1)) | 1;
+                if (is_prime(p))
+                    return p;
+            }
+        };
+        for (uint64_t bits : {20,25,30})
+        {
+            std::vector<uint64_t> ns;
+            for (int i = 0; i < 1000; ++i)
+                ns.push_back(rand_prime(bits)*rand_prime(bits));
+            auto t0 = std::chrono::steady_clock::now();
+            for (uint64_t n : ns)
+                assert(factorization(n).size() == 2);
+            auto t1 = std::chrono::steady_clock::now();
+            double sec = std::chrono::duration<double>(t1-t0).count();
+            printf("1000 semiprimes p*q with %llu bit factors: %.3f sec\n",
+                (unsigned long long) bits,sec);
+        }
+        std::vector<u128> ns;
+        for (int i = 0; i < 100; ++i)
+            ns.push_back((u128) rand_prime(40)*rand_prime(40)*rand_prime(40));
+        auto t0 = std::chrono::steady_clock::now();
+        for (u128 n : ns)
+            assert(factorization128(n).size() == 3);
+        auto t1 = std::chrono::steady_clock::now();
+        double sec = std::chrono::duration<double>(t1-t0).count();
+        printf("100 products of three 40 bit primes: %.3f sec\n",sec);
+    }
+}
@@ -0,0 +1,495 @@
+/*
+Segmented prime sieve
+
+Uses a mod 30 wheel so each byte represents 30 consecutive integers, with one
+bit for each of the 8 residues coprime to 30. The range is sieved in L1 cache
+sized segments, so memory usage is proportional to sqrt(n) (the sieving primes
+and their next multiple offsets), not n.
+
+Sieving primes below the segment size cross off directly (8 arithmetic
+progressions with stride p bytes, one per wheel bit). Larger primes hit each
+segment at most once per progression, so they are kept in buckets indexed by
+the segment of their next multiple, avoiding a scan of all primes per segment.
+
+Supports ranges with upper bound up to 2^62.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// residues coprime to 30 (bit i of a byte represents 30*byte + _wheel_res[i])
+static constexpr uint32_t _wheel_res[8] = {1,7,11,13,17,19,23,29};
+// index in _wheel_res for each residue coprime to 30
+static constexpr uint8_t _wheel_idx[30] = {0,0,0,0,0,0,0,1,0,0,0,2,0,3,0,0,0,4,
+    0,5,0,0,0,6,0,0,0,0,0,7};
+// inverse mod 30 of each residue in _wheel_res
+static constexpr uint32_t _wheel_inv[8] = {1,13,11,7,23,19,17,29};
+// segment size in bytes (30 integers per byte), sized for a 32KiB L1 cache
+static constexpr uint32_t _SIEVE_SEG = 1u << 15;
+// presieve pattern length in bytes (7*11*13)
+static constexpr uint32_t _SIEVE_PRE = 1001;
+
+// floor(sqrt(n)) for 64 bit integers
+static uint64_t _sieve_isqrt(uint64_t n)
+{
+    uint64_t r = (uint64_t) std::sqrt((double) n);
+    while (r > 0 && r*r > n)
+        --r;
+    while ((r+1)*(r+1) <= n)
+        ++r;
+    return r;
+}
+
+// primes <= n with a basic odd only sieve (for the sieving primes)
+static std::vector<uint32_t> _sieve_small_primes(uint32_t n)
+{
+    std::vector<uint32_t> ret;
+    if (n < 2)
+        return ret;
+    ret.push_back(2);
+    std::vector<uint8_t> comp(n/2+1,0); // index i -> 2*i+1
+    for (uint64_t i = 1; 2*i+1 <= n; ++i)
+    {
+        if (comp[i])
+            continue;
+        const uint64_t p = 2*i+1;
+        ret.push_back(p);
+        for (uint64_t j = p*p/2; 2*j+1 <= n; j += p)
+            comp[j] = 1;
+    }
+    return ret;
+}
+
+// sieves integers in [lo,hi) that are coprime to 30, excluding 1
+// calls f(seg,len,byte_lo) for each segment, where seg holds len bytes
+// representing 30*byte_lo through 30*(byte_lo+len)-1 and a bit is set iff its
+// integer is a prime in [lo,hi) (seg is padded with 0 to a multiple of 8 bytes)
+// primes must contain (in order) all primes up to at least sqrt(hi-1)
+template <typename F>
+void _wheel_sieve(uint64_t lo, uint64_t hi, const std::vector<uint32_t>& primes,
+    F&& f)
+{
+    lo = std::max<uint64_t>(lo,7);
+    if (lo >= hi)
+        return;
+    const uint64_t blo = lo/30, bhi = (hi+29)/30;
+    const uint32_t root = _sieve_isqrt(hi-1);
+
+    // primes < _SIEVE_SEG, offsets relative to the current segment
+    struct _medium { uint32_t p; uint32_t off[8]; };
+    // primes >= _SIEVE_SEG, pos = (offset in segment << 3) | wheel bit
+    struct _large { uint32_t p; uint32_t pos; };
+    std::vector<_medium> medium;
+    const size_t nbuckets = root/_SIEVE_SEG + 3;
+    std::vector<std::vector<_large>> buckets(nbuckets);
+
+    // presieve pattern for 7,11,13 (period 1001 bytes), copied into each
+    // segment instead of crossing off their (most frequent) multiples
+    std::vector<uint8_t> pattern(_SIEVE_PRE,0xFF);
+    for (uint32_t p : {7,11,13})
+        for (uint32_t i = 0; i < 30*_SIEVE_PRE; i += p)
+            for (uint32_t b = 0; b < 8; ++b)
+                if (i % 30 == _wheel_res[b])
+                    pattern[i/30] &= ~(1u << b);
+
+    std::vector<uint64_t> words(_SIEVE_SEG/8);
+    uint8_t *seg = (uint8_t*) words.data();
+    size_t pi = 6; // skip 2,3,5,7,11,13
+
+    for (uint64_t s = 0, slo = blo; slo < bhi; ++s, slo += _SIEVE_SEG)
+    {
+        const uint32_t len = std::min<uint64_t>(_SIEVE_SEG,bhi-slo);
+        for (uint32_t i = 0, j = slo % _SIEVE_PRE; i < len;)
+        {
+            const uint32_t k = std::min(len-i,_SIEVE_PRE-j);
+            memcpy(seg+i,pattern.data()+j,k);
+            i += k;
+            j = 0;
+        }
+        if (slo == 0) // 7,11,13 are prime
+            seg[0] |= 0b1110;
+
+        // start sieving with primes whose square is below the segment end
+        while (pi < primes.size()
+            && (uint64_t) primes[pi]*primes[pi] < 30*(slo+len))
+        {
+            const uint32_t p = primes[pi++];
+            _medium mp{p,{}};
+            // first multiple >= max(p*p,30*slo) for each wheel residue
+            const uint64_t m0 = std::max<uint64_t>(p,(30*slo+p-1)/p);
+            const uint32_t pw = _wheel_idx[p % 30];
+            for (uint32_t b = 0; b < 8; ++b)
+            {
+                // m*p = _wheel_res[b] (mod 30)
+                const uint32_t t = _wheel_res[b]*_wheel_inv[pw] % 30;
+                const uint64_t m = m0 + (t+30-m0%30) % 30;
+                const uint64_t off = p*m/30 - slo;
+                if (p < _SIEVE_SEG)
+                    mp.off[b] = off;
+                else if (slo+off < bhi)
+                    buckets[(s+off/_SIEVE_SEG) % nbuckets].push_back(
+                        {p,(uint32_t)((off%_SIEVE_SEG) << 3 | b)});
+            }
+            if (p < _SIEVE_SEG)
+                medium.push_back(mp);
+        }
+
+        for (_medium& mp : medium)
+            for (uint32_t b = 0; b < 8; ++b)
+            {
+                const uint8_t mask = ~(1u << b);
+                uint32_t i = mp.off[b];
+                for (; i < len; i += mp.p)
+                    seg[i] &= mask;
+                mp.off[b] = i - len;
+            }
+
+        std::vector<_large>& bucket = buckets[s % nbuckets];
+        for (const _large& e : bucket)
+        {
+            const uint32_t i = e.pos >> 3, b = e.pos & 7;
+            seg[i] &= ~(1u << b);
+            const uint64_t next = (uint64_t) i + e.p;
+            if (slo+next < bhi)
+                buckets[(s+next/_SIEVE_SEG) % nbuckets].push_back(
+                    {e.p,(uint32_t)((next%_SIEVE_SEG) << 3 | b)});
+        }
+        bucket.clear();
+
+        // remove bits outside [lo,hi) in the edge bytes
+        for (uint32_t b = 0; b < 8; ++b)
+        {
+            if (30*slo+_wheel_res[b] < lo)
+                seg[0] &= ~(1u << b);
+            if (30*(slo+len-1)+_wheel_res[b] >= hi)
+                seg[len-1] &= ~(1u << b);
+        }
+        const uint32_t padded = (len+7) & ~7u;
+        memset(seg+len,0,padded-len);
+        f((const uint8_t*) seg,len,slo);
+    }
+}
+
+template <typename F>
+void _wheel_sieve(uint64_t lo, uint64_t hi, F&& f)
+{
+    if (lo < hi)
+        _wheel_sieve(lo,hi,_sieve_small_primes(_sieve_isqrt(hi-1)),f);
+}
+
+// calls f(p) for each prime set in a segment from _wheel_sieve
+template <typename F>
+void _wheel_scan(const uint8_t *seg, uint32_t len, uint64_t slo, F&& f)
+{
+    for (uint32_t wi = 0; 8*wi < len; ++wi)
+    {
+        uint64_t w;
+        memcpy(&w,seg+8*wi,8);
+        const uint64_t base = 30*(slo+8*wi);
+        while (w)
+        {
+            const uint32_t k = __builtin_ctzll(w);
+            f(base + 30*(k >> 3) + _wheel_res[k & 7]);
+            w &= w-1;
+        }
+    }
+}
+
+// number of primes set in a segment from _wheel_sieve
+static uint64_t _wheel_popcount(const uint8_t *seg, uint32_t len)
+{
+    uint64_t ret = 0;
+    for (uint32_t wi = 0; 8*wi < len; ++wi)
+    {
+        uint64_t w;
+        memcpy(&w,seg+8*wi,8);
+        ret += __builtin_popcountll(w);
+    }
+    return ret;
+}
+
+// calls f(p) for each prime lo <= p < hi in increasing order
+template <typename F>
+void for_each_prime(uint64_t lo, uint64_t hi, F&& f)
+{
+    for (uint64_t p : {2,3,5})
+        if (lo <= p && p < hi)
+            f(p);
+    _wheel_sieve(lo,hi,[&](const uint8_t *seg, uint32_t len, uint64_t slo)
+    {
+        _wheel_scan(seg,len,slo,f);
+    });
+}
+
+// calls f(p) for each prime below n in increasing order
+template <typename F>
+void for_each_prime(uint64_t n, F&& f)
+{
+    for_each_prime(0,n,f);
+}
+
+// number of primes p with lo <= p < hi
+uint64_t count_primes(uint64_t lo, uint64_t hi)
+{
+    uint64_t ret = 0;
+    for (uint64_t p : {2,3,5})
+        ret += (lo <= p && p < hi);
+    _wheel_sieve(lo,hi,[&](const uint8_t *seg, uint32_t len, uint64_t)
+    {
+        ret += _wheel_popcount(seg,len);
+    });
+    return ret;
+}
+
+// number of primes below n
+uint64_t count_primes(uint64_t n)
+{
+    return count_primes(0,n);
+}
+
+// list of primes below n
+std::vector<uint64_t> list_primes(uint64_t n)
+{
+    std::vector<uint64_t> ret;
+    for_each_prime(n,[&](uint64_t p) { ret.push_back(p); });
+    return ret;
+}
+
+// splits [lo,hi) into chunks (whole segments) handed out to worker threads
+// calls work(chunk_index,chunk_lo,chunk_hi,primes) from the worker threads,
+// where primes are the sieving primes shared by all chunks
+// chunks have at most max(max_chunk,4*sqrt(hi)) bytes (and 32 segments)
+template <typename W>
+void _parallel_chunks(uint64_t lo, uint64_t hi, unsigned threads, W&& work,
+    uint64_t max_chunk = UINT64_MAX)
+{
+    lo = std::max<uint64_t>(lo,7);
+    if (lo >= hi)
+        return;
+    if (threads == 0)
+        threads = std::max(1u,std::thread::hardware_concurrency());
+    const uint32_t root = _sieve_isqrt(hi-1);
+    const std::vector<uint32_t> primes = _sieve_small_primes(root);
+    // chunks should be large enough to amortize computing the first multiple
+    // of each sieving prime, with several chunks per thread for balancing
+    const uint64_t bytes = (hi+29)/30 - lo/30;
+    uint64_t chunk = std::max<uint64_t>({
+        std::min<uint64_t>(bytes/(8*threads),max_chunk),
+        32*_SIEVE_SEG,4*(uint64_t)root});
+    chunk = (chunk+_SIEVE_SEG-1) / _SIEVE_SEG * _SIEVE_SEG;
+    const uint64_t chunks = (bytes+chunk-1) / chunk;
+    std::atomic<uint64_t> next(0);
+    auto worker = [&]()
+    {
+        for (uint64_t i; (i = next++) < chunks;)
+        {
+            const uint64_t clo = std::max(lo,30*(lo/30+i*chunk));
+            const uint64_t chi = std::min(hi,30*(lo/30+(i+1)*chunk));
+            work(i,clo,chi,primes);
+        }
+    };
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < std::min<uint64_t>(threads,chunks); ++t)
+        pool.emplace_back(worker);
+    worker();
+    for (std::thread& t : pool)
+        t.join();
+}
+
+// number of primes p with lo <= p < hi using multiple threads
+// (threads = 0 uses std::thread::hardware_concurrency())
+uint64_t count_primes_parallel(uint64_t lo, uint64_t hi, unsigned threads = 0)
+{
+    std::atomic<uint64_t> ret(0);
+    for (uint64_t p : {2,3,5})
+        ret += (lo <= p && p < hi);
+    _parallel_chunks(lo,hi,threads,[&](uint64_t, uint64_t clo, uint64_t chi,
+        const std::vector<uint32_t>& primes)
+    {
+        uint64_t cnt = 0;
+        _wheel_sieve(clo,chi,primes,[&](const uint8_t *seg, uint32_t len,
+            uint64_t) { cnt += _wheel_popcount(seg,len); });
+        ret += cnt;
+    });
+    return ret;
+}
+
+// number of primes below n using multiple threads
+uint64_t count_primes_parallel(uint64_t n, unsigned threads = 0)
+{
+    return count_primes_parallel(0,n,threads);
+}
+
+// calls f(p) for each prime lo <= p < hi in increasing order, sieving on
+// multiple threads but calling f only from the calling thread
+// workers stay within a window of 2*threads chunks ahead of the output and
+// buffer their sieved wheel bytes (1 byte per 30 integers), so with chunks of
+// at most max(64 segments,4*sqrt(hi)) bytes memory is O(threads*sqrt(hi))
+// rather than growing with hi-lo
+template <typename F>
+void for_each_prime_parallel(uint64_t lo, uint64_t hi, F&& f,
+    unsigned threads = 0)
+{
+    for (uint64_t p : {2,3,5})
+        if (lo <= p && p < hi)
+            f(p);
+    if (threads == 0)
+        threads = std::max(1u,std::thread::hardware_concurrency());
+    const uint64_t window = 2*(uint64_t)threads;
+    std::mutex mtx;
+    std::condition_variable cv;
+    // finished chunks, wheel bytes starting at byte index first
+    struct _chunk { uint64_t first; std::vector<uint8_t> bytes; };
+    std::map<uint64_t,_chunk> done;
+    uint64_t emitted = 0; // chunks passed to f
+    bool finished = false;
+    std::thread sieving([&]()
+    {
+        _parallel_chunks(lo,hi,threads,[&](uint64_t i, uint64_t clo,
+            uint64_t chi, const std::vector<uint32_t>& primes)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                cv.wait(lock,[&]() { return i < emitted+window; });
+            }
+            // padded with 0 to a multiple of 8 bytes for _wheel_scan
+            const uint64_t nbytes = (chi+29)/30 - clo/30;
+            _chunk c{clo/30,std::vector<uint8_t>((nbytes+7) & ~7ull)};
+            _wheel_sieve(clo,chi,primes,[&](const uint8_t *seg, uint32_t len,
+                uint64_t slo) { memcpy(&c.bytes[slo-c.first],seg,len); });
+            std::lock_guard<std::mutex> lock(mtx);
+            done.emplace(i,std::move(c));
+            cv.notify_all();
+        },64*_SIEVE_SEG);
+        std::lock_guard<std::mutex> lock(mtx);
+        finished = true;
+        cv.notify_all();
+    });
+    for (;;)
+    {
+        _chunk c;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            cv.wait(lock,[&]()
+                { return finished || done.count(emitted); });
+            auto it = done.find(emitted);
+            if (it == done.end())
+                break;
+            c = std::move(it->second);
+            done.erase(it);
+            ++emitted;
+            cv.notify_all();
+        }
+        for (uint64_t k = 0; k < c.bytes.size(); k += _SIEVE_SEG)
+            _wheel_scan(c.bytes.data()+k,std::min<uint64_t>(_SIEVE_SEG,
+                c.bytes.size()-k),c.first+k,f);
+    }
+    sieving.join();
+}
+
+// list of primes below n using multiple threads
+std::vector<uint64_t> list_primes_parallel(uint64_t n, unsigned threads = 0)
+{
+    std::vector<uint64_t> ret;
+    for_each_prime_parallel(0,n,[&](uint64_t p) { ret.push_back(p); },threads);
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    // compare with trial division for small inputs
+    std::vector<uint64_t> naive;
+    for (uint64_t n = 0; n <= 3000; ++n)
+    {
+        assert(list_primes(n) == naive);
+        bool prime = n >= 2;
+        for (uint64_t d = 2; d*d <= n && prime; ++d)
+            prime = n % d != 0;
+        if (prime)
+            naive.push_back(n);
+    }
+    assert(list_primes(102) == std::vector<uint64_t>({2,3,5,7,11,13,17,19,23,
+        29,31,37,41,43,47,53,59,61,67,71,73,79,83,89,97,101}));
+    assert(list_primes(1000).size() == 168);
+    uint64_t s = 0;
+    for_each_prime(10000,[&](uint64_t p) { s += p; });
+    assert(s == 5736396);
+
+    // pi(10^k)
+    const uint64_t pi10[] = {0,4,25,168,1229,9592,78498,664579,5761455,
+        50847534};
+    for (uint64_t k = 0, n = 1; k <= 9; ++k, n *= 10)
+        assert(count_primes(n) == pi10[k]);
+
+    // ranges across segment boundaries with large sieving primes
+    const uint64_t base = 1000000000000ull;
+    uint64_t cnt = 0, last = 0;
+    for_each_prime(base,base+2000000,[&](uint64_t p)
+    {
+        assert(p > last && p % 7 != 0 && p % 11 != 0 && p % 13 != 0);
+        last = p;
+        ++cnt;
+    });
+    assert(cnt == count_primes(base,base+2000000));
+    assert(count_primes(base,base+1000) == 37);
+    for (uint64_t lo = 0; lo < 200; lo += 7)
+        for (uint64_t hi = lo; hi < 1200; hi += 13)
+            assert(count_primes(lo,hi) == count_primes(hi) - count_primes(lo));
+
+    // parallel versions must match the sequential sieve
+    for (unsigned t : {1,2,3,8})
+    {
+        assert(list_primes_parallel(3000,t) == naive);
+        assert(count_primes_parallel(1000000000,t) == 50847534);
+        assert(count_primes_parallel(base,base+2000000,t) == cnt);
+        std::vector<uint64_t> ps;
+        for_each_prime_parallel(base,base+2000000,
+            [&](uint64_t p) { ps.push_back(p); },t);
+        assert(ps.size() == cnt && ps.back() == last);
+        assert(std::is_sorted(ps.begin(),ps.end()));
+    }
+    assert(list_primes_parallel(20000000,4) == list_primes(20000000));
+
+    // run with "bench" argument for timing
+    if (argc > 1 && std::string(argv[1]) == "bench")
+    {
+        for (uint64_t n = 1000000; n <= 10000000000ull; n *= 10)
+        {
+            auto t0 = std::chrono::steady_clock::now();
+            uint64_t c = count_primes(n);
+            auto t1 = std::chrono::steady_clock::now();
+            double sec = std::chrono::duration<double>(t1-t0).count();
+            printf("pi(%llu) = %llu (%.3f sec)\n",
+                (unsigned long long) n,(unsigned long long) c,sec);
+        }
+        // scaling with thread count
+        const uint64_t n = 10000000000ull;
+        const unsigned hw = std::max(1u,std::thread::hardware_concurrency());
+        double base_rate = 0;
+        for (unsigned t = 1; t <= hw; t = (t < hw && 2*t > hw) ? hw : 2*t)
+        {
+            auto t0 = std::chrono::steady_clock::now();
+            uint64_t c = count_primes_parallel(n,t);
+            auto t1 = std::chrono::steady_clock::now();
+            double sec = std::chrono::duration<double>(t1-t0).count();
+            double rate = c/sec;
+            if (t == 1)
+                base_rate = rate;
+            printf("%u threads: pi(%llu) = %llu (%.3f sec, %.3e primes/sec, "
+                "speedup %.2f)\n",t,(unsigned long long) n,
+                (unsigned long long) c,sec,rate,rate/base_rate);
+        }
+    }
+}
@@ -0,0 +1,214 @@
+/*
+Smallest prime factor sieve
+
+Linear sieve (each composite is marked exactly once, by its smallest prime
+factor) building a table to factor any integer up to n in O(log n). The table
+is packed to 16 bits per odd integer: every odd composite up to 2^32 has a
+smallest prime factor below 2^16, and primes are stored as 0. Even integers are
+handled by counting trailing zeros, so the table uses n bytes for n < 2^32.
+*/
+
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+class spf_sieve
+{
+    uint32_t _n;
+    std::vector<uint16_t> _spf; // index i -> 2*i+1, 0 if prime (or 1)
+    std::vector<uint32_t> _primes;
+
+public:
+    // sieve for integers 1..n
+    spf_sieve(uint32_t n): _n(n), _spf(n/2+1,0)
+    {
+        if (n >= 2)
+            _primes.push_back(2);
+        for (uint64_t i = 3; i <= n; i += 2)
+        {
+            const uint32_t si = _spf[i/2];
+            if (si == 0)
+                _primes.push_back(i);
+            // mark p*i for odd primes p <= spf(i)
+            for (size_t j = 1; j < _primes.size(); ++j)
+            {
+                const uint64_t p = _primes[j];
+                if ((si != 0 && p > si) || p*i > n)
+                    break;
+                _spf[p*i/2] = p;
+            }
+        }
+    }
+
+    // upper limit of the table
+    uint32_t limit() const { return _n; }
+
+    // primes up to limit()
+    const std::vector<uint32_t>& primes() const { return _primes; }
+
+    // smallest prime factor of 2 <= x <= limit()
+    uint32_t spf(uint32_t x) const
+    {
+        assert(2 <= x && x <= _n);
+        if (x % 2 == 0)
+            return 2;
+        const uint32_t s = _spf[x/2];
+        return s ? s : x;
+    }
+
+    bool is_prime(uint32_t x) const
+    {
+        assert(x <= _n);
+        return x == 2 || (x % 2 == 1 && x > 1 && _spf[x/2] == 0);
+    }
+
+    // calls f(p,e) for each prime power p^e in x (increasing p)
+    template <typename F>
+    void factor(uint32_t x, F&& f) const
+    {
+        assert(1 <= x && x <= _n);
+        if (x % 2 == 0)
+        {
+            const uint32_t e = __builtin_ctz(x);
+            f(2u,e);
+            x >>= e;
+        }
+        while (x > 1)
+        {
+            const uint32_t s = _spf[x/2];
+            const uint32_t p = s ? s : x;
+            uint32_t e = 0;
+            do
+            {
+                x /= p;
+                ++e;
+            }
+            while (x % p == 0);
+            f(p,e);
+        }
+    }
+
+    // prime factorization (increasing order with correct multiplicity)
+    std::vector<uint32_t> factorization(uint32_t x) const
+    {
+        std::vector<uint32_t> ret;
+        factor(x,[&](uint32_t p, uint32_t e) { ret.insert(ret.end(),e,p); });
+        return ret;
+    }
+
+    // euler totient function
+    uint32_t totient(uint32_t x) const
+    {
+        uint32_t ret = x;
+        factor(x,[&](uint32_t p, uint32_t) { ret = ret/p*(p-1); });
+        return ret;
+    }
+
+    // mobius function
+    int mobius(uint32_t x) const
+    {
+        int ret = 1;
+        factor(x,[&](uint32_t, uint32_t e) { ret = e > 1 ? 0 : -ret; });
+        return ret;
+    }
+
+    // number of divisors
+    uint32_t divisor_count(uint32_t x) const
+    {
+        uint32_t ret = 1;
+        factor(x,[&](uint32_t, uint32_t e) { ret *= e+1; });
+        return ret;
+    }
+};
+
+// trial division factorization for comparison
+static std::vector<uint32_t> _trial_factorization(uint32_t n)
+{
+    std::vector<uint32_t> ret;
+    for (uint32_t d = 2; (uint64_t) d*d <= n; ++d)
+        while (n % d == 0)
+        {
+            ret.push_back(d);
+            n /= d;
+        }
+    if (n != 1)
+        ret.push_back(n);
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    const spf_sieve small(10000);
+    assert(small.primes().size() == 1229);
+    for (uint32_t x = 1; x <= 10000; ++x)
+    {
+        const std::vector<uint32_t> f = _trial_factorization(x);
+        assert(small.factorization(x) == f);
+        assert(small.is_prime(x) == (f.size() == 1));
+        bool squarefree = true;
+        for (size_t i = 1; i < f.size(); ++i)
+            squarefree &= f[i] != f[i-1];
+        const int mu = squarefree ? (f.size() % 2 ? -1 : 1) : 0;
+        if (x > 2000)
+        {
+            assert(small.mobius(x) == mu);
+            continue;
+        }
+        uint32_t phi = 0, d = 0;
+        for (uint32_t k = 1; k <= x; ++k)
+        {
+            uint32_t a = k, b = x;
+            while (b)
+            {
+                a %= b;
+                std::swap(a,b);
+            }
+            phi += a == 1;
+            d += x % k == 0;
+        }
+        assert(small.totient(x) == phi);
+        assert(small.divisor_count(x) == d);
+        assert(small.mobius(x) == mu);
+    }
+    assert(!small.is_prime(0) && !small.is_prime(1));
+
+    const spf_sieve big(30000000);
+    assert(big.primes().size() == 1857859);
+    assert(big.factorization(13435741)
+        == std::vector<uint32_t>({11,31,31,31,41}));
+    assert(big.factorization(29999999) == _trial_factorization(29999999));
+    assert(big.totient(25769263) == 21209472);
+    assert(big.totient(64) == 32 && big.totient(72) == 24);
+    assert(big.mobius(30) == -1 && big.mobius(29988149) == -1);
+    assert(big.divisor_count(27720) == 96);
+    assert(big.spf(29999999) == 29999999 && big.spf(29988149) == 61);
+
+    // run with "bench" argument for timing
+    if (argc > 1 && std::string(argv[1]) == "bench")
+    {
+        const uint32_t n = 10000000;
+        auto t0 = std::chrono::steady_clock::now();
+        const spf_sieve s(n);
+        auto t1 = std::chrono::steady_clock::now();
+        uint64_t sum = 0;
+        for (uint32_t x = 1; x <= n; ++x)
+            s.factor(x,[&](uint32_t p, uint32_t e) { sum += p*e; });
+        auto t2 = std::chrono::steady_clock::now();
+        uint64_t sum2 = 0;
+        for (uint32_t x = 1; x <= n; ++x)
+            for (uint32_t p : _trial_factorization(x))
+                sum2 += p;
+        auto t3 = std::chrono::steady_clock::now();
+        assert(sum == sum2);
+        printf("build table n=%u: %.3f sec\n",n,
+            std::chrono::duration<double>(t1-t0).count());
+        printf("factor 1..n with table: %.3f sec\n",
+            std::chrono::duration<double>(t2-t1).count());
+        printf("factor 1..n with trial division: %.3f sec\n",
+            std::chrono::duration<double>(t3-t2).count());
+    }
+}